@@ -0,0 +1,86 @@
+#include <check.hpp>
+#include <toylang/batch.hpp>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::string_view> const* strings(toylang::batch::Output const& out) { return std::get_if<std::vector<std::string_view>>(&out.values); }
+} // namespace
+
+TL_TEST(batch_short_string_global) {
+	auto in = toylang::Interpreter{};
+	check.expect(in.execute({.text = "var tag = \"ab\";"}));
+	auto const names = std::array<std::string_view, 1>{"x"};
+	auto const expr = in.compile_expr("tag", names);
+	check.expect(static_cast<bool>(expr));
+	auto const xs = std::array<double, 3>{1.0, 2.0, 3.0};
+	auto const columns = std::array<toylang::batch::Column, 1>{std::span<double const>{xs}};
+	auto out = toylang::batch::Output{};
+	check.expect(in.evaluate(expr, columns, out));
+	auto const* values = strings(out);
+	if (!check.expect(values && values->size() == xs.size(), "string column of 3 rows")) { return; }
+	for (auto const value : *values) { check.expect_eq(value, "ab"); }
+	// a second batch reuses the output
+	check.expect(in.evaluate(expr, columns, out));
+	values = strings(out);
+	if (!check.expect(values && values->size() == xs.size(), "string column of 3 rows")) { return; }
+	for (auto const value : *values) { check.expect_eq(value, "ab"); }
+}
+
+TL_TEST(batch_matches_rows) {
+	auto in = toylang::Interpreter{};
+	check.expect(in.execute({.text = "var limit = 2;"}));
+	auto const names = std::array<std::string_view, 2>{"x", "name"};
+	auto const expr = in.compile_expr("x * 2 > limit and name != \"b\"", names);
+	auto const xs = std::array<double, 4>{0.0, 2.0, 3.0, 4.0};
+	auto const ns = std::array<std::string_view, 4>{"a", "a", "b", "c"};
+	auto const columns = std::array<toylang::batch::Column, 2>{std::span<double const>{xs}, std::span<std::string_view const>{ns}};
+	auto out = toylang::batch::Output{};
+	check.expect(in.evaluate(expr, columns, out));
+	auto const* values = std::get_if<std::vector<std::uint8_t>>(&out.values);
+	if (!check.expect(values && values->size() == xs.size(), "bool column of 4 rows")) { return; }
+	check.expect(*values == std::vector<std::uint8_t>{0, 1, 0, 1});
+}
+
+TL_TEST(batch_matches_evaluate_across_chunks) {
+	// rows spanning several chunks, with and / or selecting different subsets of each
+	auto in = toylang::Interpreter{};
+	check.expect(in.execute({.text = "var limit = 1500;"}));
+	auto const names = std::array<std::string_view, 2>{"x", "flag"};
+	auto const expr = in.compile_expr("(x > limit or flag) and (x < 2800 or !flag) and -x / 2 + 1 != 0", names);
+	auto xs = std::vector<double>(3000);
+	auto flags = std::vector<std::uint8_t>(xs.size());
+	for (std::size_t i = 0; i < xs.size(); ++i) {
+		xs[i] = static_cast<double>(i);
+		flags[i] = static_cast<std::uint8_t>((i / 7) & 1);
+	}
+	auto const columns = std::array<toylang::batch::Column, 2>{std::span<double const>{xs}, std::span<std::uint8_t const>{flags}};
+	auto out = toylang::batch::Output{};
+	check.expect(in.evaluate(expr, columns, out));
+	auto const* values = std::get_if<std::vector<std::uint8_t>>(&out.values);
+	if (!check.expect(values && values->size() == xs.size(), "bool column")) { return; }
+	for (std::size_t i = 0; i < xs.size(); ++i) {
+		auto const bindings = std::array<toylang::Value, 2>{toylang::Value{.payload = xs[i]}, toylang::Value{.payload = toylang::Bool{flags[i] != 0}}};
+		if (in.evaluate(expr, bindings) != toylang::Value{.payload = toylang::Bool{(*values)[i] != 0}}) {
+			check.expect(false, "row " + std::to_string(i));
+			return;
+		}
+	}
+}
+
+TL_TEST(reset_releases_bindings) {
+	auto in = toylang::Interpreter{};
+	auto const image = in.snapshot();
+	auto const names = std::array<std::string_view, 1>{"s"};
+	auto const expr = in.compile_expr("s", names);
+	auto const buffer = std::make_shared<std::string const>("bound value");
+	auto const bindings = std::array<toylang::Value, 1>{toylang::Value{.payload = toylang::StrSlice{.buffer = buffer, .length = buffer->size()}}};
+	auto const result = in.evaluate(expr, bindings);
+	check.expect(result.is_string() && result.as_string() == "bound value");
+	in.reset(image);
+	// buffer, bindings and result: not the interpreter
+	check.expect(buffer.use_count() == 3, "binding frame released by reset");
+	auto const again = in.evaluate(in.compile_expr("s", names), std::array<toylang::Value, 1>{toylang::Value{.payload = 1.0}});
+	check.expect(again.contains<double>() && again.get<double>() == 1.0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <toylang/interpreter.hpp>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tl_test {
+///
+/// \brief Failures of the running test (file:line: message)
+///
+class Check {
+  public:
+	bool expect(bool condition, std::string_view message = {}, std::source_location const where = std::source_location::current());
+	bool expect_eq(std::string_view actual, std::string_view expected, std::source_location const where = std::source_location::current());
+
+	std::vector<std::string> const& failures() const { return m_failures; }
+
+  private:
+	std::vector<std::string> m_failures{};
+};
+
+using TestFn = void (*)(Check&);
+
+///
+/// \brief Registers a test at static initialization (see TL_TEST)
+///
+struct Registrar {
+	Registrar(std::string_view name, TestFn fn);
+};
+
+///
+/// \brief Script run in a fresh Interpreter (the stdlib embedded): its output, diagnostics and whether it succeeded
+///
+struct Run {
+	std::string output{};
+	std::string diagnostics{};
+	bool ok{};
+};
+
+Run run(std::string_view script);
+} // namespace tl_test
+
+#define TL_TEST(name)                                                                                                                                          \
+	static void name(::tl_test::Check& check);                                                                                                                 \
+	static ::tl_test::Registrar const name##_registrar{#name, &name};                                                                                          \
+	static void name([[maybe_unused]] ::tl_test::Check& check)
@@ -0,0 +1,68 @@
+#include <check.hpp>
+#include <array>
+
+TL_TEST(expression_evaluates_with_bindings) {
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.redirect(&output, &diagnostics);
+	check.expect(in.execute({.text = "fn discount(price) { return price * 0.5; }"}));
+	auto const names = std::array<std::string_view, 2>{"price", "vip"};
+	auto const expr = in.compile_expr("vip and discount(price) or price", names);
+	if (!check.expect(static_cast<bool>(expr), diagnostics)) { return; }
+	check.expect(expr.names().size() == 2, "names kept");
+	for (auto const vip : {false, true}) {
+		auto const bindings = std::array<toylang::Value, 2>{toylang::Value{.payload = 10.0}, toylang::Value{.payload = toylang::Bool{vip}}};
+		check.expect(in.evaluate(expr, bindings) == toylang::Value{.payload = vip ? 5.0 : 10.0}, vip ? "vip" : "regular");
+	}
+	check.expect_eq(output, "");
+}
+
+TL_TEST(expression_bindings_are_local) {
+	auto in = toylang::Interpreter{};
+	auto diagnostics = std::string{};
+	in.redirect(nullptr, &diagnostics);
+	check.expect(in.execute({.text = "fn leak() { return x; }"}));
+	auto const names = std::array<std::string_view, 1>{"x"};
+	auto const expr = in.compile_expr("leak()", names);
+	auto const bindings = std::array<toylang::Value, 1>{toylang::Value{.payload = 1.0}};
+	// functions it calls don't see the bindings: an error, null, and the next evaluation runs regardless
+	check.expect(in.evaluate(expr, bindings) == toylang::Value{}, "null on error");
+	check.expect(in.is_errored());
+	auto const plain = in.compile_expr("x + 1", names);
+	check.expect(in.evaluate(plain, bindings) == toylang::Value{.payload = 2.0}, "evaluates after an error");
+}
+
+TL_TEST(expression_calls_after_failed_record) {
+	auto in = toylang::Interpreter{};
+	auto diagnostics = std::string{};
+	in.redirect(nullptr, &diagnostics);
+	check.expect(in.execute({.text = "fn twice(x) { return x * 2; }\nfn size(x) { return _len(x); }"}));
+	auto const names = std::array<std::string_view, 1>{"x"};
+	auto const bind = [](toylang::Value value) { return std::array<toylang::Value, 1>{std::move(value)}; };
+	// a record that throws, then records that call the same function
+	auto const twice = in.compile_expr("twice(x)", names);
+	check.expect(in.evaluate(twice, bind({.payload = 3.0})) == toylang::Value{.payload = 6.0});
+	check.expect(in.evaluate(twice, bind({.payload = std::string{"ab"}})) == toylang::Value{}, "failed record is null");
+	check.expect(in.is_errored(), "reported");
+	check.expect(in.evaluate(twice, bind({.payload = 4.0})) == toylang::Value{.payload = 8.0}, "evaluates after a failed record");
+	check.expect(in.evaluate(twice, bind({.payload = 5.0})) == toylang::Value{.payload = 10.0}, "and after that");
+	// an intrinsic reports without throwing
+	auto const size = in.compile_expr("size(x)", names);
+	check.expect(in.evaluate(size, bind({.payload = 1.0})) == toylang::Value{}, "intrinsic error is null");
+	check.expect(in.evaluate(size, bind({.payload = std::string{"abc"}})) == toylang::Value{.payload = 3.0}, "evaluates after an intrinsic error");
+}
+
+TL_TEST(expression_invalid_text) {
+	auto in = toylang::Interpreter{};
+	auto diagnostics = std::string{};
+	in.redirect(nullptr, &diagnostics);
+	check.expect(!in.compile_expr("1 2"), "trailing tokens");
+	// cut short at the end: the parser itself doesn't report this
+	diagnostics.clear();
+	check.expect(!in.compile_expr("1 +"), "incomplete");
+	check.expect(diagnostics.find("Unexpected end of expression") != std::string::npos, diagnostics);
+	// an earlier error doesn't fail the next parse
+	check.expect(static_cast<bool>(in.compile_expr("1 + 2")), "valid after errors");
+	check.expect(in.is_errored(), "error flag kept");
+}
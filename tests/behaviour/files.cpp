@@ -0,0 +1,281 @@
+#include <check.hpp>
+#include <toylang/util.hpp>
+#include <toylang/util/file_reader.hpp>
+#include <toylang/util/text_buf.hpp>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+///
+/// \brief Fresh directory under the system temp path, removed on destruction
+///
+struct TempDir {
+	fs::path path{fs::temp_directory_path() / ("tl-test-" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())))};
+
+	TempDir() { fs::create_directories(path); }
+	~TempDir() { fs::remove_all(path); }
+
+	std::string write(std::string_view const name, std::string_view const text) const {
+		auto const ret = (path / name).string();
+		toylang::util::write_file(ret.c_str(), text);
+		return ret;
+	}
+};
+} // namespace
+
+TL_TEST(text_buf_missing_and_empty) {
+	auto const dir = TempDir{};
+	check.expect(!toylang::util::TextBuf::map((dir.path / "missing.tl").string().c_str()), "missing file is false");
+	auto const empty = toylang::util::TextBuf::map(dir.write("empty.tl", "").c_str());
+	check.expect(static_cast<bool>(empty) && empty.view().empty(), "empty file is true");
+	auto const text = toylang::util::TextBuf::map(dir.write("text.tl", "abc").c_str());
+	check.expect(static_cast<bool>(text));
+	check.expect_eq(text.view(), "abc");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TL_TEST(text_buf_reads_fifo) {
+	auto const dir = TempDir{};
+	auto const path = (dir.path / "fifo").string();
+	if (!check.expect(::mkfifo(path.c_str(), 0600) == 0, "mkfifo")) { return; }
+	auto writer = std::thread{[&path] { toylang::util::write_file(path.c_str(), "_print(5);"); }};
+	auto const text = toylang::util::TextBuf::map(path.c_str());
+	writer.join();
+	check.expect(static_cast<bool>(text) && !text.is_mapped());
+	check.expect_eq(text.view(), "_print(5);");
+}
+#endif
+
+TL_TEST(execute_file_reports_missing) {
+	auto const dir = TempDir{};
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.redirect(&output, &diagnostics);
+	check.expect(!in.execute_file((dir.path / "missing.tl").string().c_str()));
+	check.expect(diagnostics.find("Failed to read file") != std::string::npos, diagnostics);
+	check.expect(in.execute_file(dir.write("empty.tl", "").c_str()), diagnostics);
+}
+
+TL_TEST(import_reports_missing_and_accepts_empty) {
+	auto const dir = TempDir{};
+	dir.write("empty.tl", "");
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.media.mount(dir.path.string());
+	in.redirect(&output, &diagnostics);
+	check.expect(in.execute({.text = "import \"empty.tl\";\n_print(1);"}), diagnostics);
+	check.expect_eq(output, "1\n");
+	check.expect(!in.execute({.text = "import \"missing.tl\";\n_print(2);"}));
+	check.expect(diagnostics.find("missing.tl") != std::string::npos, diagnostics);
+	check.expect_eq(output, "1\n");
+}
+
+TL_TEST(media_cache_follows_changes) {
+	auto const dir = TempDir{};
+	auto media = toylang::Media{};
+	media.cache_contents = true;
+	check.expect(media.mount(dir.path.string()));
+	check.expect(media.resolve("a.tl").empty());
+	dir.write("a.tl", "first");
+	auto text = std::string{};
+	check.expect(media.read_to(text, "a.tl"));
+	check.expect_eq(text, "first");
+	// copies share the cache, and see the file's new contents (its size / mtime changed)
+	auto const copy = media;
+	dir.write("a.tl", "second version");
+	check.expect(copy.read_to(text, "a.tl"));
+	check.expect_eq(text, "second version");
+	fs::remove(dir.path / "a.tl");
+	check.expect(media.resolve("a.tl").empty());
+	check.expect(!media.read_to(text, "a.tl"));
+}
+
+TL_TEST(media_cache_sees_shadowing_file) {
+	auto const dir = TempDir{};
+	fs::create_directories(dir.path / "first");
+	fs::create_directories(dir.path / "second");
+	auto media = toylang::Media{};
+	media.cache_contents = true;
+	check.expect(media.mount((dir.path / "first").string()) && media.mount((dir.path / "second").string()));
+	dir.write("second/a.tl", "from second");
+	auto text = std::string{};
+	check.expect(media.read_to(text, "a.tl"));
+	check.expect_eq(text, "from second");
+	// added later under the earlier mount: it wins over the cached resolution
+	dir.write("first/a.tl", "from first");
+	check.expect(media.read_to(text, "a.tl"));
+	check.expect_eq(text, "from first");
+	check.expect_eq(fs::path{media.resolve("a.tl")}.parent_path().filename().string(), "first");
+}
+
+TL_TEST(media_cache_concurrent_reads) {
+	auto const dir = TempDir{};
+	auto media = toylang::Media{};
+	media.cache_contents = true;
+	check.expect(media.mount(dir.path.string()));
+	for (auto i = 0; i < 4; ++i) { dir.write("f" + std::to_string(i) + ".tl", std::string(1000 + i, static_cast<char>('a' + i))); }
+	auto failures = std::atomic<int>{};
+	{
+		auto readers = std::vector<std::jthread>{};
+		for (auto t = 0; t < 4; ++t) {
+			readers.emplace_back([&, t] {
+				auto text = std::string{};
+				for (auto n = 0; n < 200; ++n) {
+					auto const i = (t + n) % 4;
+					if (!media.read_to(text, "f" + std::to_string(i) + ".tl") || text != std::string(1000 + i, static_cast<char>('a' + i))) { ++failures; }
+				}
+			});
+		}
+	}
+	check.expect(failures == 0, "every read returns its own file");
+}
+
+TL_TEST(media_embedded_first) {
+	auto const dir = TempDir{};
+	dir.write("b.tl", "from disk");
+	static constexpr toylang::Media::Embedded embedded_v[] = {{.uri = "b.tl", .text = "embedded"}};
+	auto media = toylang::Media{};
+	media.mount(dir.path.string());
+	media.embedded = embedded_v;
+	auto text = std::string{};
+	check.expect(media.read_to(text, "b.tl"));
+	check.expect_eq(text, "embedded");
+}
+
+TL_TEST(embedded_empty_module_shadows_disk) {
+	auto const dir = TempDir{};
+	dir.write("empty.tl", "_print(\"from disk\");");
+	static constexpr toylang::Media::Embedded embedded_v[] = {{.uri = "empty.tl", .text = ""}};
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.redirect(&output, &diagnostics);
+	in.media.mount(dir.path.string());
+	in.media.embedded = embedded_v;
+	check.expect(in.media.find_embedded("empty.tl").has_value(), "found, though empty");
+	check.expect(in.execute({.text = "import \"empty.tl\";\n_print(\"done\");"}), diagnostics);
+	check.expect_eq(output, "done\n");
+	auto text = std::string{"stale"};
+	check.expect(in.media.read_to(text, "empty.tl"));
+	check.expect_eq(text, "");
+}
+
+namespace {
+// runs main_text with dir mounted and the module cache on; its output (diagnostics on failure)
+std::string run_cached(TempDir const& dir, std::string_view const main_text) {
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.media.mount(dir.path.string());
+	in.cache.modules = true;
+	in.redirect(&output, &diagnostics);
+	if (!in.execute({.text = main_text})) { return diagnostics; }
+	return output;
+}
+} // namespace
+
+TL_TEST(module_cache_round_trip) {
+	auto const dir = TempDir{};
+	dir.write("lib.tl", "struct Pair {\n\tvar a;\n\tvar b;\n}\nfn twice(x) {\n\tvar i = 0;\n\twhile (i < 1) { i = i + 1; }\n\treturn x * 2;\n}\nvar greeting = \"hi\";\n");
+	auto const main_text = std::string_view{"import \"lib.tl\";\nvar p = Pair();\np.a = twice(21);\n_print(p.a);\n_print(greeting);"};
+	check.expect_eq(run_cached(dir, main_text), "42\nhi\n");
+	check.expect(fs::exists(dir.path / "lib.tlc"), "compiled module written next to its source");
+	// loaded from the .tlc this time
+	check.expect_eq(run_cached(dir, main_text), "42\nhi\n");
+	// a changed source invalidates it
+	dir.write("lib.tl", "fn twice(x) { return x * 3; }\nvar greeting = \"changed\";\nstruct Pair {\n\tvar a;\n}\n");
+	check.expect_eq(run_cached(dir, main_text), "63\nchanged\n");
+	// a corrupt cache file is ignored
+	dir.write("lib.tlc", "garbage");
+	check.expect_eq(run_cached(dir, main_text), "63\nchanged\n");
+}
+
+TL_TEST(file_reader_small_buffer) {
+	auto const dir = TempDir{};
+	// lines straddle the 4 byte buffer, one is longer than it, the last has no terminator
+	auto const path = dir.write("lines.txt", "ab\r\ncdefghij\n\nxyz");
+	auto reader = toylang::util::FileReader{path.c_str(), 4};
+	if (!check.expect(static_cast<bool>(reader), "open")) { return; }
+	auto lines = std::vector<std::string_view>{};
+	auto buffers = std::vector<std::shared_ptr<std::string const>>{};
+	for (auto line = std::string_view{}; reader.read_line(line);) {
+		// held views stay valid while their buffer is
+		lines.push_back(line);
+		buffers.push_back(reader.buffer());
+	}
+	check.expect(lines == std::vector<std::string_view>{"ab", "cdefghij", "", "xyz"}, "lines");
+	check.expect(reader.capacity() >= 8, "buffer grew to fit the long line");
+}
+
+TL_TEST(file_reader_chunks) {
+	auto const dir = TempDir{};
+	auto reader = toylang::util::FileReader{dir.write("chunks.txt", "abcdefgh").c_str(), 4};
+	auto chunks = std::string{};
+	auto longest = std::size_t{};
+	for (auto chunk = std::string_view{}; reader.read_chunk(chunk, 3);) {
+		chunks.append(chunk);
+		longest = std::max(longest, chunk.size());
+	}
+	check.expect_eq(chunks, "abcdefgh");
+	check.expect(longest == 3, "chunks are at most the requested size");
+	check.expect(!toylang::util::FileReader{(dir.path / "missing.txt").string().c_str()}, "missing file");
+}
+
+TL_TEST(file_streaming_intrinsics) {
+	auto const dir = TempDir{};
+	auto const path = dir.write("data.txt", "one\ntwo\nthree\n");
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn count(total, line) { return total + 1; }
+var file = _open(")" + path + R"(");
+_print(_read_line(file));
+_print(_read_chunk(file, 3));
+_close(file);
+_print(_read_line(file));
+_print(reduce(file_lines(")" + path + R"("), count, 0));
+_print(_open(")" + (dir.path / "missing.txt").string() + R"("));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "one\ntwo\nnull\n3\nnull\n");
+}
+
+TL_TEST(module_cache_concurrent_writers) {
+	auto const dir = TempDir{};
+	dir.write("lib.tl", "fn twice(x) { return x * 2; }\n");
+	auto outputs = std::vector<std::string>(8);
+	{
+		auto writers = std::vector<std::jthread>{};
+		for (auto& output : outputs) {
+			writers.emplace_back([&] { output = run_cached(dir, "import \"lib.tl\";\n_print(twice(21));"); });
+		}
+	}
+	for (auto const& output : outputs) { check.expect_eq(output, "42\n"); }
+	// every writer renamed its own temporary into place: none are left, and the survivor loads
+	for (auto const& entry : fs::directory_iterator{dir.path}) { check.expect(entry.path().extension() != ".tmp", entry.path().string()); }
+	check.expect_eq(run_cached(dir, "import \"lib.tl\";\n_print(twice(4));"), "8\n");
+}
+
+TL_TEST(file_expression_prints_value) {
+	auto const dir = TempDir{};
+	auto const path = dir.write("expr.tl", "6 * 7\n");
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	in.redirect(&output, nullptr);
+	// like a line at the prompt
+	check.expect(in.execute_or_evaluate_file(path.c_str()));
+	check.expect_eq(output, "42\n");
+	output.clear();
+	check.expect(in.execute_file(dir.write("script.tl", "_print(1);").c_str()));
+	check.expect(in.execute_or_evaluate_file((dir.path / "script.tl").string().c_str()));
+	check.expect_eq(output, "1\n1\n");
+}
@@ -0,0 +1,37 @@
+#include <check.hpp>
+
+TL_TEST(generator_yields_in_order) {
+	auto const result = tl_test::run(R"(
+fn count(n) {
+	var i = 0;
+	while (i < n) {
+		yield i;
+		i = i + 1;
+	}
+}
+var it = count(3);
+while (!_done(it)) {
+	var value = _next(it);
+	if (value != null) { _print(value); }
+}
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "0\n1\n2\n");
+}
+
+TL_TEST(generator_error_in_loop_ends_generator) {
+	// _len reports without throwing: the loop must not spin on
+	auto const result = tl_test::run(R"(
+fn spin() {
+	var i = 0;
+	while (i < 1) { _len(1); }
+	yield 1;
+}
+var it = spin();
+_next(it);
+_print("unreachable");
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("_len") != std::string::npos, result.diagnostics);
+	check.expect(result.output.find("unreachable") == std::string::npos, result.output);
+}
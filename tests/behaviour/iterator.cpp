@@ -0,0 +1,56 @@
+#include <check.hpp>
+
+TL_TEST(iterator_pipeline) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn square(x) { return x * x; }
+fn is_small(x) { return x < 5; }
+fn add(a, b) { return a + b; }
+_print(reduce(map(filter(range(0, 10), is_small), square), add, 0));
+_print(reduce(_range(10, 0, -3), add, 0));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "30\n22\n");
+}
+
+TL_TEST(iterator_is_lazy) {
+	// take stops pulling from map once it has its count
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn loud(x) {
+	_print("map");
+	return x;
+}
+var it = take(map(range(0, 100), loud), 2);
+while (!_done(it)) {
+	var value = _next(it);
+	if (value != null) { _print(value); }
+}
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "map\n0\nmap\n1\n");
+}
+
+TL_TEST(iterator_sources) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn add(a, b) { return a + b; }
+fn gen() {
+	yield 5;
+	yield 6;
+}
+var list = list_make(1);
+list_push_back(list, 2);
+list_push_back(list, 3);
+_print(reduce(zip(list, range(10, 20), add), add, 0));
+_print(reduce(iter(gen()), add, 0));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "39\n11\n");
+}
+
+TL_TEST(iterator_rejects_bad_arguments) {
+	auto const result = tl_test::run(R"(_range(0, 10, 0);)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("_range") != std::string::npos, result.diagnostics);
+}
@@ -0,0 +1,48 @@
+#include <check.hpp>
+#include <string>
+
+namespace {
+// output of _print(_json_stringify(_json_parse(<json>))), the JSON spelled as a script string literal
+std::string round_trip(std::string_view const literal) {
+	auto script = std::string{"_print(_json_stringify(_json_parse(\""};
+	script += literal;
+	script += "\")));";
+	return tl_test::run(script).output;
+}
+} // namespace
+
+TL_TEST(json_numbers) {
+	check.expect_eq(round_trip("[0, -0.5, 12, 1e2, 2.5E-1]"), "[0,-0.5,12,100,0.25]\n");
+	// RFC 8259: no leading zeros, digits after '.' and in exponents, no '+' / inf / nan
+	for (auto const* bad : {"01", "[1, 02]", "-01", "1.", "1.e3", "1e", "1e+", "+1", ".5", "inf", "-nan", "0x10"}) {
+		check.expect_eq(round_trip(bad), "null\n");
+	}
+}
+
+TL_TEST(json_surrogates) {
+	// U+1F600 as a pair
+	check.expect_eq(round_trip("\\\"\\\\ud83d\\\\ude00\\\""), "\"\xf0\x9f\x98\x80\"\n");
+	// lone high / low halves, or a high half followed by something else
+	for (auto const* bad : {"\\\"\\\\ud800\\\"", "\\\"\\\\udc00\\\"", "\\\"\\\\ud83dx\\\"", "\\\"\\\\ud83d\\\\u0041\\\""}) {
+		check.expect_eq(round_trip(bad), "null\n");
+	}
+}
+
+TL_TEST(json_keys_outlive_document) {
+	// keys are stored per document and owned by its objects: they must survive the text, copies and tasks
+	auto const result = tl_test::run(R"(
+fn parse(i) { return _json_parse(_str("{\"key_") + _str(i) + _str("\": ") + _str(i) + _str("}")); }
+fn get(obj, i) { return _field(obj, _str("key_") + _str(i)); }
+var kept = parse(1);
+var i = 2;
+while (i < 200) {
+	parse(i);
+	i = i + 1;
+}
+_print(get(kept, 1));
+_print(get(_join(_spawn(parse, 7)), 7));
+_print(_json_stringify(_deserialize(_serialize(kept))));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "1\n7\n{\"key_1\":1}\n");
+}
@@ -0,0 +1,72 @@
+#include <check.hpp>
+#include <toylang/stdlib.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace tl_test {
+namespace {
+struct Entry {
+	std::string_view name{};
+	TestFn fn{};
+};
+
+std::vector<Entry>& registry() {
+	static auto ret = std::vector<Entry>{};
+	return ret;
+}
+} // namespace
+
+bool Check::expect(bool const condition, std::string_view const message, std::source_location const where) {
+	if (condition) { return true; }
+	auto failure = std::string{where.file_name()};
+	failure += ':';
+	failure += std::to_string(where.line());
+	failure += ": ";
+	failure += message.empty() ? std::string_view{"expectation failed"} : message;
+	m_failures.push_back(std::move(failure));
+	return false;
+}
+
+bool Check::expect_eq(std::string_view const actual, std::string_view const expected, std::source_location const where) {
+	if (actual == expected) { return true; }
+	auto message = std::string{"expected ["};
+	message += expected;
+	message += "] got [";
+	message += actual;
+	message += ']';
+	return expect(false, message, where);
+}
+
+Registrar::Registrar(std::string_view const name, TestFn const fn) { registry().push_back({name, fn}); }
+
+Run run(std::string_view const script) {
+	auto ret = Run{};
+	auto in = toylang::Interpreter{};
+	in.media.embedded = toylang::stdlib::files();
+	in.redirect(&ret.output, &ret.diagnostics);
+	ret.ok = in.execute({.text = script});
+	return ret;
+}
+} // namespace tl_test
+
+///
+/// \brief Runs every registered test (or those named on the command line)
+///
+int main(int argc, char** argv) {
+	auto const filter = std::vector<std::string_view>(argv + 1, argv + argc);
+	auto failed = 0;
+	auto ran = 0;
+	for (auto const& [name, fn] : tl_test::registry()) {
+		if (!filter.empty() && std::find(filter.begin(), filter.end(), name) == filter.end()) { continue; }
+		auto check = tl_test::Check{};
+		fn(check);
+		++ran;
+		if (check.failures().empty()) { continue; }
+		++failed;
+		std::printf("FAIL %.*s\n", static_cast<int>(name.size()), name.data());
+		for (auto const& failure : check.failures()) { std::printf("  %s\n", failure.c_str()); }
+	}
+	std::printf("%d / %d tests passed\n", ran - failed, ran);
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+#include <check.hpp>
+
+TL_TEST(memo_caches_results) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var calls = 0;
+fn square(x) {
+	calls = calls + 1;
+	return x * x;
+}
+var fast = memoize(square, 8);
+_print(fast(3));
+_print(fast(3));
+_print(calls);
+_print(memo_stats(fast).hits);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "9\n9\n1\n1\n");
+}
+
+TL_TEST(memo_result_mutation_does_not_leak) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+struct Box {
+	var value;
+}
+fn make(x) {
+	var ret = Box();
+	ret.value = x;
+	return ret;
+}
+var cached = memoize(make, 8);
+var a = cached(1);
+a.value = 42;
+var b = cached(1);
+_print(b.value);
+b.value = 7;
+_print(cached(1).value);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "1\n1\n");
+}
+
+TL_TEST(memo_caches_after_unrelated_error) {
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	in.redirect(&output, &diagnostics);
+	check.expect(in.execute({.text = "var calls = 0;\nfn square(x) {\n\tcalls = calls + 1;\n\treturn x * x;\n}\nvar fast = _memoize(square, 8);"}));
+	// an error that has nothing to do with the memoized function
+	in.evaluate("_len(1)");
+	check.expect(in.is_errored(), "reported");
+	output.clear();
+	in.evaluate("fast(3)");
+	in.evaluate("fast(3)");
+	in.evaluate("calls");
+	in.evaluate("_memo_stats(fast).hits");
+	check.expect_eq(output, "9\n9\n1\n1\n");
+}
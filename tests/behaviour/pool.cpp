@@ -0,0 +1,48 @@
+#include <check.hpp>
+#include <toylang/util/thread_pool.hpp>
+#include <atomic>
+#include <thread>
+
+TL_TEST(pool_nested_pushes_complete) {
+	auto pool = toylang::util::ThreadPool{4};
+	auto count = std::atomic<int>{};
+	auto same_thread = std::atomic<int>{};
+	for (auto i = 0; i < 64; ++i) {
+		pool.push([&] {
+			auto const parent = std::this_thread::get_id();
+			for (auto j = 0; j < 16; ++j) {
+				pool.push([&, parent] {
+					if (std::this_thread::get_id() == parent) { ++same_thread; }
+					++count;
+				});
+			}
+			// help with queued work (the children, first) instead of blocking
+			while (pool.try_run()) {}
+		});
+	}
+	pool.wait();
+	check.expect(count == 64 * 16);
+	// children go to their parent's queue: most run where they were pushed (the rest are stolen)
+	check.expect(same_thread > 0, "no child ran on its parent's worker");
+}
+
+TL_TEST(nested_spawn_join) {
+	auto const result = tl_test::run(R"(
+struct Box {
+	var value;
+}
+var box = Box();
+box.value = 10;
+fn leaf(n) { return n + box.value; }
+fn branch(n) {
+	var a = _spawn(leaf, n);
+	var b = _spawn(leaf, n + 1);
+	return _join(a) + _join(b);
+}
+_print(_join(_spawn(branch, 1)));
+box.value = 0;
+_print(_join(_spawn(branch, 1)));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "23\n3\n");
+}
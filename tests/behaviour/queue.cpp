@@ -0,0 +1,52 @@
+#include <check.hpp>
+#include <toylang/util/mpmc_queue.hpp>
+#include <array>
+#include <thread>
+
+namespace {
+std::size_t fill(toylang::util::MpmcQueue<int>& queue) {
+	auto ret = std::size_t{};
+	for (auto value = 0; queue.try_push(value); value = static_cast<int>(++ret)) {}
+	return ret;
+}
+} // namespace
+
+TL_TEST(queue_holds_exact_capacity) {
+	for (auto const capacity : {std::size_t{1}, std::size_t{2}, std::size_t{3}, std::size_t{5}, std::size_t{8}}) {
+		auto queue = toylang::util::MpmcQueue<int>{capacity};
+		check.expect(queue.capacity() == capacity);
+		check.expect(fill(queue) == capacity, "fills to capacity");
+		// room for one more after a pop, in order
+		auto out = -1;
+		check.expect(queue.try_pop(out) && out == 0);
+		auto value = 42;
+		check.expect(queue.try_push(value));
+		check.expect(!queue.try_push(value), "full again");
+	}
+}
+
+TL_TEST(queue_concurrent_sum) {
+	constexpr auto count_v = 20000;
+	auto queue = toylang::util::MpmcQueue<int>{3};
+	auto sums = std::array<long long, 2>{};
+	auto threads = std::vector<std::thread>{};
+	for (auto p = 0; p < 2; ++p) {
+		threads.emplace_back([&queue] {
+			for (auto i = 1; i <= count_v; ++i) {
+				auto value = i;
+				while (!queue.try_push(value)) { std::this_thread::yield(); }
+			}
+		});
+	}
+	for (auto c = 0; c < 2; ++c) {
+		threads.emplace_back([&queue, &sum = sums[static_cast<std::size_t>(c)]] {
+			for (auto i = 0; i < count_v; ++i) {
+				auto value = 0;
+				while (!queue.try_pop(value)) { std::this_thread::yield(); }
+				sum += value;
+			}
+		});
+	}
+	for (auto& thread : threads) { thread.join(); }
+	check.expect(sums[0] + sums[1] == 2LL * count_v * (count_v + 1) / 2);
+}
@@ -0,0 +1,88 @@
+#include <check.hpp>
+#include <toylang/stdlib.hpp>
+#include <algorithm>
+
+TL_TEST(print_and_arithmetic) {
+	auto const result = tl_test::run("_print(1 + 2 * 3);");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "7\n");
+}
+
+TL_TEST(runtime_error_fails) {
+	auto const result = tl_test::run("_print(1 < \"a\");");
+	check.expect(!result.ok);
+	check.expect(!result.diagnostics.empty());
+}
+
+TL_TEST(stdlib_import) {
+	auto const result = tl_test::run("import \"std.tl\";\nprint(list_size(sort(range(0, 3))));");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "3\n");
+}
+
+TL_TEST(output_streams_through_on_output) {
+	auto in = toylang::Interpreter{};
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	auto streamed = std::vector<std::string>{};
+	in.redirect(&output, &diagnostics);
+	in.on_output = [&streamed](std::string& out) {
+		if (out.size() < 4) { return; }
+		streamed.push_back(std::move(out));
+		out.clear();
+	};
+	check.expect(in.execute({.text = "_print(12); _print(345); _print(6);"}), diagnostics);
+	check.expect(streamed == std::vector<std::string>{"12\n345\n"});
+	check.expect_eq(output, "6\n");
+}
+
+TL_TEST(printf_formats) {
+	auto const result = tl_test::run(R"(
+var i = 0;
+while (i < 3) {
+	_printf("{}: {} {}\n", i, "x", i * 2);
+	i = i + 1;
+}
+_printf("missing {} {}\n", 1);
+_printf("none\n");
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "0: x 0\n1: x 2\n2: x 4\nmissing 1 {}\nnone\n");
+}
+
+TL_TEST(printf_unterminated) {
+	auto const result = tl_test::run(R"(_printf("oops {", 1);)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("Unterminated") != std::string::npos, result.diagnostics);
+}
+
+TL_TEST(number_conversions) {
+	auto const result = tl_test::run(R"(
+_print(_str(0.1 + 0.2));
+_print(_str(-0));
+_print(_str(1000000 * 1000000 * 1000000 * 1000));
+_print(_str(123456789));
+_print(1 / 3);
+_print(_num("42.5") + 1);
+_print(_num("1e3"));
+_print(_num("abc"));
+_print(_num(" 7"));
+_print(_num(_str(1 / 3)) == 1 / 3);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "0.30000000000000004\n0\n1e+21\n123456789\n0.3333333333333333\n43.5\n1000\nnull\nnull\ntrue\n");
+}
+
+TL_TEST(stdlib_embedded_files) {
+	auto const files = toylang::stdlib::files();
+	check.expect(std::ranges::any_of(files, [](auto const& file) { return file.uri == "std.tl"; }), "std.tl embedded");
+	// every module imports on its own, with nothing mounted
+	for (auto const& file : files) {
+		auto script = std::string{"import \""};
+		script += file.uri;
+		script += "\";";
+		auto const result = tl_test::run(script);
+		check.expect(result.ok, result.diagnostics);
+		check.expect(!file.text.empty(), file.uri);
+	}
+}
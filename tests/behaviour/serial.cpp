@@ -0,0 +1,78 @@
+#include <check.hpp>
+#include <filesystem>
+
+TL_TEST(serialize_preserves_sharing) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+struct Pair {
+	var a;
+	var b;
+}
+var shared = Pair();
+shared.a = "shared text that is longer than small";
+var top = Pair();
+top.a = shared;
+top.b = shared;
+var copy = deserialize(serialize(top));
+_print(copy.a == copy.b);
+_print(copy.a == shared);
+copy.a.b = 5;
+_print(copy.b.b);
+_print(shared.b);
+_print(copy.b.a);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "true\nfalse\n5\nnull\nshared text that is longer than small\n");
+}
+
+TL_TEST(serialize_list_cycles) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var list = list_make(1);
+list_push_back(list, "two");
+list_push_back(list, true);
+var back = deserialize(serialize(list));
+_print(list_size(back));
+_print(back.next.prev == back);
+_print(back.next.next.value);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "3\ntrue\ntrue\n");
+}
+
+TL_TEST(deserialize_rejects_corrupt_input) {
+	// every truncation of a valid encoding, and bytes that never were one, decode to null
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var list = list_make(1.5);
+list_push_back(list, "a string longer than the small size");
+var bytes = serialize(list);
+var i = 0;
+var rejected = 0;
+while (i < _len(bytes)) {
+	if (deserialize(_substr(bytes, 0, i)) == null) { rejected = rejected + 1; }
+	i = i + 1;
+}
+_print(rejected == _len(bytes));
+_print(deserialize("garbage"));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "true\nnull\n");
+}
+
+TL_TEST(save_load_round_trip) {
+	auto const path = (std::filesystem::temp_directory_path() / "tl-test-serial.bin").string();
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var list = list_make("first");
+list_push_back(list, 2);
+_print(serialize_to_file(list, ")" + path + R"("));
+var back = deserialize_file(")" + path + R"(");
+_print(back.value);
+_print(back.next.value);
+_print(deserialize_file(")" + path + R"(.missing"));
+)");
+	std::filesystem::remove(path);
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "true\nfirst\n2\nnull\n");
+}
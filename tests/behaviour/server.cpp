@@ -0,0 +1,161 @@
+#include <check.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+struct Frame {
+	char kind{};
+	std::string payload{};
+};
+
+///
+/// \brief The runner in --serve mode (one job, timeout in ms), killed on destruction
+///
+class ServerProcess {
+  public:
+	explicit ServerProcess(std::string path, std::string timeout = "5000") : m_path(std::move(path)) {
+		std::filesystem::remove(m_path);
+		char const* argv[] = {TL_EXE, "--serve", m_path.c_str(), "--jobs", "1", "--timeout", timeout.c_str(), nullptr};
+		if (::posix_spawn(&m_pid, TL_EXE, nullptr, nullptr, const_cast<char**>(argv), environ) != 0) { m_pid = -1; }
+	}
+
+	~ServerProcess() {
+		if (m_pid > 0) {
+			::kill(m_pid, SIGTERM);
+			::waitpid(m_pid, nullptr, 0);
+		}
+		std::filesystem::remove(m_path);
+	}
+
+	///
+	/// \brief Connected socket (retries while the server starts up), -1 on failure
+	///
+	int connect() const {
+		auto address = sockaddr_un{};
+		address.sun_family = AF_UNIX;
+		std::strncpy(address.sun_path, m_path.c_str(), sizeof(address.sun_path) - 1);
+		for (int attempt = 0; attempt < 100 && m_pid > 0; ++attempt) {
+			int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0) {
+				// a starved request fails the test instead of hanging it
+				auto const timeout = timeval{.tv_sec = 5, .tv_usec = 0};
+				::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+				return fd;
+			}
+			::close(fd);
+			std::this_thread::sleep_for(std::chrono::milliseconds{50});
+		}
+		return -1;
+	}
+
+  private:
+	std::string m_path{};
+	pid_t m_pid{-1};
+};
+
+bool read_all(int fd, char* out, std::size_t size) {
+	while (size > 0) {
+		auto const ret = ::read(fd, out, size);
+		if (ret <= 0) { return false; }
+		out += ret;
+		size -= static_cast<std::size_t>(ret);
+	}
+	return true;
+}
+
+bool send(int fd, char kind, std::string_view const payload) {
+	char header[5]{kind};
+	auto const size = static_cast<std::uint32_t>(payload.size());
+	for (std::size_t i = 0; i < 4; ++i) { header[1 + i] = static_cast<char>((size >> (8 * i)) & 0xff); }
+	return ::write(fd, header, sizeof(header)) == sizeof(header) && ::write(fd, payload.data(), payload.size()) == static_cast<ssize_t>(payload.size());
+}
+
+// frames up to and including the final 'r' (empty on failure / timeout)
+std::vector<Frame> receive(int fd) {
+	auto ret = std::vector<Frame>{};
+	while (true) {
+		unsigned char header[5];
+		if (!read_all(fd, reinterpret_cast<char*>(header), sizeof(header))) { return {}; }
+		auto const size = std::uint32_t{header[1]} | std::uint32_t{header[2]} << 8 | std::uint32_t{header[3]} << 16 | std::uint32_t{header[4]} << 24;
+		auto& frame = ret.emplace_back(Frame{.kind = static_cast<char>(header[0])});
+		frame.payload.resize(size);
+		if (!read_all(fd, frame.payload.data(), size)) { return {}; }
+		if (frame.kind == 'r') { return ret; }
+	}
+}
+
+std::string output_of(std::vector<Frame> const& frames) {
+	auto ret = std::string{};
+	for (auto const& frame : frames) {
+		if (frame.kind == 'o') { ret += frame.payload; }
+	}
+	return ret;
+}
+} // namespace
+
+TL_TEST(server_idle_connection_does_not_starve) {
+	auto const server = ServerProcess{(std::filesystem::temp_directory_path() / "tl-test-server.sock").string()};
+	int const idle = server.connect();
+	if (!check.expect(idle >= 0, "connect")) { return; }
+	check.expect(send(idle, 'e', "1 + 1"));
+	check.expect_eq(output_of(receive(idle)), "2\n");
+	// one job, held by nothing: the idle keep-alive connection must not block another client
+	int const other = server.connect();
+	check.expect(send(other, 'e', "6 * 7"));
+	auto const frames = receive(other);
+	check.expect(!frames.empty() && frames.back().payload == "ok", "second client served");
+	check.expect_eq(output_of(frames), "42\n");
+	// and the idle one is still served afterwards
+	check.expect(send(idle, 'x', "print(3);"));
+	check.expect_eq(output_of(receive(idle)), "3\n");
+	::close(other);
+	::close(idle);
+}
+
+TL_TEST(server_drops_partial_frame) {
+	auto const server = ServerProcess{(std::filesystem::temp_directory_path() / "tl-test-server-partial.sock").string(), "300"};
+	int const stalled = server.connect();
+	if (!check.expect(stalled >= 0, "connect")) { return; }
+	// a header promising 100 bytes, then nothing: the only worker reads it until the request timeout
+	char const header[] = {'x', 100, 0, 0, 0, 'p'};
+	check.expect(::write(stalled, header, sizeof(header)) == sizeof(header));
+	std::this_thread::sleep_for(std::chrono::milliseconds{50});
+	int const other = server.connect();
+	check.expect(send(other, 'e', "6 * 7"));
+	auto const frames = receive(other);
+	check.expect(!frames.empty() && frames.back().payload == "ok", "served once the stalled read timed out");
+	check.expect_eq(output_of(frames), "42\n");
+	// and the stalled connection was closed
+	char byte{};
+	check.expect(::read(stalled, &byte, 1) == 0, "stalled connection closed");
+	::close(other);
+	::close(stalled);
+}
+
+TL_TEST(server_streams_output) {
+	auto const server = ServerProcess{(std::filesystem::temp_directory_path() / "tl-test-server-stream.sock").string()};
+	int const fd = server.connect();
+	if (!check.expect(fd >= 0, "connect")) { return; }
+	check.expect(send(fd, 'x', R"(var i = 0; while (i < 5000) { print("0123456789"); i = i + 1; })"));
+	auto const frames = receive(fd);
+	auto outputs = std::size_t{};
+	for (auto const& frame : frames) { outputs += frame.kind == 'o' ? 1 : 0; }
+	check.expect(outputs > 1, "output arrives in several frames");
+	check.expect(output_of(frames).size() == 5000 * 11);
+	::close(fd);
+}
+#endif
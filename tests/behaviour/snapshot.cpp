@@ -0,0 +1,100 @@
+#include <check.hpp>
+#include <toylang/interpreter_pool.hpp>
+#include <toylang/stdlib.hpp>
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Captured {
+	std::string output{};
+	std::string diagnostics{};
+
+	bool run(toylang::Interpreter& in, std::string_view const text) {
+		output.clear();
+		in.redirect(&output, &diagnostics);
+		return in.execute({.text = text});
+	}
+};
+
+toylang::Interpreter::Image make_image() {
+	auto in = toylang::Interpreter{};
+	in.media.embedded = toylang::stdlib::files();
+	in.execute({.text = "import \"std.tl\";\nstruct Counter {\n\tvar n;\n}\nvar counter = Counter();\ncounter.n = 0;\nfn bump() {\n\tcounter.n = counter.n + 1;\n\treturn counter.n;\n}"});
+	return in.snapshot();
+}
+} // namespace
+
+TL_TEST(snapshot_clones_are_independent) {
+	auto const image = make_image();
+	auto a = toylang::Interpreter{image};
+	auto b = toylang::Interpreter{image};
+	auto out = Captured{};
+	check.expect(out.run(a, "bump(); _print(bump());"), out.diagnostics);
+	check.expect_eq(out.output, "2\n");
+	// b starts from the image, not from a's state; stdlib imports are not re-run
+	check.expect(out.run(b, "_print(bump()); _print(len(\"abc\"));"), out.diagnostics);
+	check.expect_eq(out.output, "1\n3\n");
+}
+
+TL_TEST(pool_resets_between_leases) {
+	auto pool = toylang::InterpreterPool{make_image()};
+	auto out = Captured{};
+	{
+		auto lease = pool.acquire();
+		check.expect(out.run(lease.get(), "bump(); var leaked = 1; _print(bump());"), out.diagnostics);
+		check.expect_eq(out.output, "2\n");
+	}
+	check.expect(pool.idle() == 1);
+	auto lease = pool.acquire();
+	check.expect(pool.created() == 1, "released instance reused");
+	check.expect(out.run(lease.get(), "_print(bump());"), out.diagnostics);
+	check.expect_eq(out.output, "1\n");
+	// globals defined by the last request are gone
+	check.expect(!out.run(lease.get(), "_print(leaked);"));
+}
+
+TL_TEST(shared_program_across_threads) {
+	auto const image = make_image();
+	auto compiler = toylang::Interpreter{image};
+	auto const program = compiler.compile({.text = "var total = 0;\nvar i = 0;\nwhile (i < 2000) {\n\ttotal = total + i;\n\ti = i + 1;\n}\n_print(total + bump());"});
+	if (!check.expect(static_cast<bool>(program), "compiled")) { return; }
+	constexpr auto threads_v = std::size_t{8};
+	auto outputs = std::array<std::string, threads_v>{};
+	auto results = std::array<bool, threads_v>{};
+	{
+		auto threads = std::vector<std::jthread>{};
+		for (std::size_t t = 0; t < threads_v; ++t) {
+			threads.emplace_back([&, t] {
+				auto in = toylang::Interpreter{image};
+				auto diagnostics = std::string{};
+				in.redirect(&outputs[t], &diagnostics);
+				// every instance runs the same statements, each twice
+				results[t] = in.execute(program) && in.execute(program);
+			});
+		}
+	}
+	for (std::size_t t = 0; t < threads_v; ++t) {
+		check.expect(results[t]);
+		check.expect_eq(outputs[t], "1999001\n1999002\n");
+	}
+}
+
+TL_TEST(pool_lease_stats) {
+	auto pool = toylang::InterpreterPool{make_image()};
+	auto out = Captured{};
+	auto baseline = toylang::Interpreter::Stats{};
+	{
+		auto lease = pool.acquire();
+		check.expect(out.run(lease.get(), "var x = 1;"), out.diagnostics);
+		baseline = lease.release();
+	}
+	auto lease = pool.acquire();
+	check.expect(out.run(lease.get(), "var a = \"text\"; var b = 2; var c = 3;"), out.diagnostics);
+	auto const stats = lease.release();
+	// the cloned globals count as well as this request's: two more than the other request bound
+	check.expect(baseline.values > 1, "cloned globals counted");
+	check.expect(stats.values == baseline.values + 2, "values bound by the request");
+	check.expect(stats.arena.bytes > 0, "source text copied");
+	check.expect(stats.statements > 0);
+}
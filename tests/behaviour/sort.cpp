@@ -0,0 +1,82 @@
+#include <check.hpp>
+
+TL_TEST(sort_list_in_place) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var list = list_make(3);
+list_push_back(list, 1);
+list_push_back(list, 2);
+_print(sort(list) == list);
+_print(list.value);
+_print(list.next.value);
+_print(list.next.next.value);
+_print(list.next.next.prev.value);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "true\n1\n2\n3\n2\n");
+}
+
+TL_TEST(sort_by_is_stable) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn shorter(a, b) { return _len(a) < _len(b); }
+var list = list_make("bb");
+list_push_back(list, "a");
+list_push_back(list, "cc");
+list_push_back(list, "d");
+sort_by(list, shorter);
+var node = list;
+while (node != null) {
+	_print(node.value);
+	node = node.next;
+}
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "a\nd\nbb\ncc\n");
+}
+
+TL_TEST(sort_iterables_into_new_list) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn greater(a, b) { return a > b; }
+_print(sort_by(range(0, 5), greater).value);
+_print(sort(map(range(8, 11), _str)).value);
+)");
+	check.expect(result.ok, result.diagnostics);
+	// strings sort by characters: "10" before "8"
+	check.expect_eq(result.output, "4\n10\n");
+}
+
+TL_TEST(sort_large_uses_parallel_merge) {
+	// past the parallel threshold, values rising then falling
+	auto const result = tl_test::run(R"(
+import "std.tl";
+fn mul(a, b) { return a * b; }
+var list = sort(zip(range(0, 70000), _range(70000, 0, -1), mul));
+var node = list;
+var count = 0;
+var ordered = true;
+while (node != null) {
+	if (node.next != null) {
+		if (node.next.value < node.value) { ordered = false; }
+	}
+	count = count + 1;
+	node = node.next;
+}
+_print(count);
+_print(ordered);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "70000\ntrue\n");
+}
+
+TL_TEST(sort_rejects_mixed_types) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var list = list_make(1);
+list_push_back(list, "a");
+sort(list);
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("_sort") != std::string::npos, result.diagnostics);
+}
@@ -0,0 +1,130 @@
+#include <check.hpp>
+#include <toylang/util.hpp>
+#include <toylang/util/str_search.hpp>
+#include <toylang/value.hpp>
+#include <memory>
+
+TL_TEST(slice_short_strings_are_copied) {
+	auto const buffer = std::make_shared<std::string const>(std::string(100, 'x') + "short");
+	auto const value = toylang::Value::make_slice(buffer, std::string_view{*buffer}.substr(100));
+	check.expect(value.contains<std::string>(), "small strings don't hold the buffer");
+	check.expect_eq(value.as_string(), "short");
+	check.expect(buffer.use_count() == 1, "buffer not shared");
+}
+
+TL_TEST(slice_views_and_compacts) {
+	auto const buffer = std::make_shared<std::string const>(std::string(1000, 'x') + "a slice longer than small");
+	auto value = toylang::Value::make_slice(buffer, std::string_view{*buffer}.substr(1000));
+	check.expect(value.contains<toylang::StrSlice>(), "long strings are slices");
+	check.expect(value == toylang::Value{.payload = std::string{"a slice longer than small"}}, "slices compare as strings");
+	check.expect(value.hash() == toylang::Value{.payload = std::string{"a slice longer than small"}}.hash(), "and hash as strings");
+	// a slice much smaller than its buffer is copied out
+	toylang::compact(value);
+	check.expect(value.contains<std::string>(), "compacted");
+	check.expect(buffer.use_count() == 1, "buffer released");
+	check.expect_eq(value.as_string(), "a slice longer than small");
+	// one that covers most of it is left alone
+	auto whole = toylang::Value::make_slice(buffer, *buffer);
+	toylang::compact(whole);
+	check.expect(whole.contains<toylang::StrSlice>(), "large slice kept");
+}
+
+TL_TEST(slices_are_transparent_to_scripts) {
+	auto const result = tl_test::run(R"(
+var text = "the quick brown fox jumps over the lazy dog";
+var a = _substr(text, 4, 30);
+var b = _substr(text, 4, 30);
+_print(a);
+_print(a == b);
+_print(a < "zzz");
+_print(a + "!");
+_print(_len(a));
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "quick brown fox jumps over the\ntrue\ntrue\nquick brown fox jumps over the!\n30\n");
+}
+
+TL_TEST(str_search_matches_std) {
+	// needles at every offset of a haystack longer than a few SIMD blocks, including partial matches and the tail
+	auto haystack = std::string(100, 'a');
+	for (auto const needle : {std::string_view{"ab"}, std::string_view{"aab"}, std::string_view{"b"}, std::string_view{"abcab"}}) {
+		for (std::size_t at = 0; at + needle.size() <= haystack.size(); ++at) {
+			auto text = haystack;
+			text.replace(at, needle.size(), needle);
+			auto const view = std::string_view{text};
+			if (toylang::util::find(view, needle) != view.find(needle) || toylang::util::rfind(view, needle) != view.rfind(needle)) {
+				check.expect(false, std::string{needle} + " at " + std::to_string(at));
+				return;
+			}
+		}
+	}
+	check.expect(toylang::util::find("abc", "") == 0, "empty needle");
+	check.expect(toylang::util::find("abc", "abcd") == toylang::util::npos_v, "needle longer than haystack");
+	check.expect(toylang::util::find("abcabc", "abc", 1) == 3, "from");
+	check.expect(toylang::util::find("abc", "c", 10) == toylang::util::npos_v, "from past the end");
+}
+
+TL_TEST(str_search_count_replace_trim) {
+	check.expect(toylang::util::count("aaaa", "aa") == 2, "non-overlapping");
+	check.expect(toylang::util::count("abc", "") == 0, "empty needle");
+	check.expect_eq(toylang::util::replace("a-b--c", "-", "+"), "a+b++c");
+	check.expect_eq(toylang::util::replace("aaaa", "aa", "b"), "bb");
+	check.expect_eq(toylang::util::trim(" \t\r\n x y \n"), "x y");
+	check.expect_eq(toylang::util::trim("   "), "");
+}
+
+TL_TEST(string_intrinsics) {
+	auto const result = tl_test::run(R"(
+import "std.tl";
+var text = "  alpha,beta,,gamma  ";
+_print(_find(text, "beta"));
+_print(_find(text, "delta"));
+_print(_rfind(text, "a"));
+_print(_count(text, ","));
+_print(_starts_with(text, "  al"));
+_print(_replace(text, ",", ";"));
+_print(_trim(text));
+var parts = _split(_trim(text), ",");
+while (!_done(parts)) {
+	var part = _next(parts);
+	if (part != null) { _print("[" + part + "]"); }
+}
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "8\n-1\n18\n3\ntrue\n  alpha;beta;;gamma  \nalpha,beta,,gamma\n[alpha]\n[beta]\n[]\n[gamma]\n");
+}
+
+TL_TEST(unescape_at_every_offset) {
+	// each escape at every position across two SIMD blocks: its result must not depend on where a block boundary falls
+	struct Case {
+		std::string_view escaped{};
+		std::string_view expected{};
+	};
+	static constexpr Case cases_v[] = {
+		{R"(\n)", "\n"},
+		{R"(\t)", "\t"},
+		{R"(\r)", "\r"},
+		{R"(\0)", std::string_view{"\0", 1}},
+		{R"(\")", "\""},
+		{R"(\\)", "\\"},
+		{R"(\x41)", "A"},
+		{R"(\x7e)", "~"},
+		// unknown / malformed: kept as is
+		{R"(\q)", R"(\q)"},
+		{R"(\xZ1)", R"(\xZ1)"},
+	};
+	for (auto const& [escaped, expected] : cases_v) {
+		for (std::size_t at = 0; at < 40; ++at) {
+			auto const pad = std::string(at, 'a');
+			auto const tail = std::string(40 - at, 'b');
+			if (toylang::util::unescape(pad + std::string{escaped} + tail) != pad + std::string{expected} + tail) {
+				check.expect(false, std::string{escaped} + " at " + std::to_string(at));
+				return;
+			}
+		}
+	}
+	// sequences cut short by the end of the input are kept as is
+	check.expect_eq(toylang::util::unescape(std::string(20, 'a') + "\\"), std::string(20, 'a') + "\\");
+	check.expect_eq(toylang::util::unescape(std::string(20, 'a') + R"(\x4)"), std::string(20, 'a') + R"(\x4)");
+	check.expect_eq(toylang::util::unescape(R"(\\n)"), R"(\n)");
+}
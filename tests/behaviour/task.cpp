@@ -0,0 +1,60 @@
+#include <check.hpp>
+
+TL_TEST(task_args_are_copies) {
+	auto const result = tl_test::run(R"(
+struct Box {
+	var value;
+}
+fn bump(box) {
+	box.value = box.value + 1;
+	return box.value;
+}
+var box = Box();
+box.value = 1;
+_print(_join(_spawn(bump, box)));
+_print(box.value);
+)");
+	check.expect(result.ok, result.diagnostics);
+	check.expect_eq(result.output, "2\n1\n");
+}
+
+TL_TEST(task_rejects_generator_arg) {
+	auto const result = tl_test::run(R"(
+fn gen() { yield 1; }
+fn first(g) { return _next(g); }
+_spawn(first, gen());
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("cannot be passed to a task") != std::string::npos, result.diagnostics);
+}
+
+TL_TEST(task_rejects_generator_result) {
+	auto const result = tl_test::run(R"(
+fn gen() { yield 1; }
+fn make() { return gen(); }
+_join(_spawn(make));
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("cannot be returned from a task") != std::string::npos, result.diagnostics);
+}
+
+TL_TEST(task_sees_invalid_global_generator) {
+	auto const result = tl_test::run(R"(
+fn gen() { yield 1; }
+var shared = gen();
+fn first() { return _next(shared); }
+_join(_spawn(first));
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("Invalid generator") != std::string::npos, result.diagnostics);
+}
+
+TL_TEST(channel_rejects_generator) {
+	auto const result = tl_test::run(R"(
+fn gen() { yield 1; }
+var ch = _channel(1);
+_send(ch, gen());
+)");
+	check.expect(!result.ok);
+	check.expect(result.diagnostics.find("_send") != std::string::npos, result.diagnostics);
+}
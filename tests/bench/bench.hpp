@@ -0,0 +1,79 @@
+#pragma once
+#include <toylang/interpreter.hpp>
+#include <chrono>
+#include <string_view>
+
+namespace tl_bench {
+///
+/// \brief Times a benchmark body: run() calls it until enough time has passed, reports the time per iteration
+///
+class State {
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	template <typename F>
+	void run(F&& f, std::size_t items_per_iteration = 1) {
+		f();
+		auto iterations = std::size_t{};
+		auto const start = Clock::now();
+		auto elapsed = Clock::duration{};
+		while (elapsed < min_time_v) {
+			f();
+			++iterations;
+			elapsed = Clock::now() - start;
+		}
+		m_seconds = std::chrono::duration<double>(elapsed).count() / static_cast<double>(iterations);
+		m_items = items_per_iteration;
+	}
+
+	double seconds() const { return m_seconds; }
+	std::size_t items() const { return m_items; }
+
+  private:
+	static constexpr auto min_time_v = std::chrono::milliseconds{200};
+
+	double m_seconds{};
+	std::size_t m_items{1};
+};
+
+///
+/// \brief Keeps a benchmarked computation from being optimized away or hoisted out of the timed loop
+///
+template <typename T>
+void keep(T const& value) {
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static_cast<void>(*static_cast<T const volatile*>(&value));
+#endif
+}
+
+using BenchFn = void (*)(State&);
+
+///
+/// \brief Registers a benchmark at static initialization (see TL_BENCH)
+///
+struct Registrar {
+	Registrar(std::string_view name, BenchFn fn);
+};
+
+///
+/// \brief Fresh Interpreter with the stdlib embedded and std.tl imported; output is discarded.
+/// Timed loops run a compiled program: storage doesn't grow with the iterations.
+///
+struct Script {
+	std::string output{};
+	std::string diagnostics{};
+	toylang::Interpreter in{};
+
+	Script();
+	bool execute(std::string_view text);
+	toylang::Interpreter::Program compile(std::string_view text);
+	bool execute(toylang::Interpreter::Program const& program);
+};
+} // namespace tl_bench
+
+#define TL_BENCH(name)                                                                                                                                         \
+	static void name(::tl_bench::State& state);                                                                                                                \
+	static ::tl_bench::Registrar const name##_registrar{#name, &name};                                                                                         \
+	static void name(::tl_bench::State& state)
@@ -0,0 +1,54 @@
+#include <bench.hpp>
+#include <toylang/stdlib.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace tl_bench {
+namespace {
+struct Entry {
+	std::string_view name{};
+	BenchFn fn{};
+};
+
+std::vector<Entry>& registry() {
+	static auto ret = std::vector<Entry>{};
+	return ret;
+}
+} // namespace
+
+Registrar::Registrar(std::string_view const name, BenchFn const fn) { registry().push_back({name, fn}); }
+
+Script::Script() {
+	in.media.embedded = toylang::stdlib::files();
+	in.redirect(&output, &diagnostics);
+	in.execute({.text = R"(import "std.tl";)"});
+}
+
+bool Script::execute(std::string_view const text) {
+	output.clear();
+	return in.execute({.text = text});
+}
+
+toylang::Interpreter::Program Script::compile(std::string_view const text) { return in.compile({.text = text}); }
+
+bool Script::execute(toylang::Interpreter::Program const& program) {
+	output.clear();
+	return in.execute(program);
+}
+} // namespace tl_bench
+
+///
+/// \brief Runs every registered benchmark (or those whose names contain an argument): build in Release for meaningful numbers
+///
+int main(int argc, char** argv) {
+	auto const filter = std::vector<std::string_view>(argv + 1, argv + argc);
+	for (auto const& [name, fn] : tl_bench::registry()) {
+		auto const selected = [name = name](std::string_view const f) { return name.find(f) != std::string_view::npos; };
+		if (!filter.empty() && std::ranges::none_of(filter, selected)) { continue; }
+		auto state = tl_bench::State{};
+		fn(state);
+		auto const per_item = state.seconds() / static_cast<double>(state.items());
+		std::printf("%-40.*s %12.1f ns/item %14.0f items/s\n", static_cast<int>(name.size()), name.data(), per_item * 1e9, 1.0 / per_item);
+	}
+}
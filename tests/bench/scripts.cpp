@@ -0,0 +1,300 @@
+#include <bench.hpp>
+#include <toylang/batch.hpp>
+#include <toylang/stdlib.hpp>
+#include <toylang/util.hpp>
+#include <toylang/util/str_search.hpp>
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+TL_BENCH(printf_cached_format) {
+	auto script = tl_bench::Script{};
+	auto const program = script.compile(R"(var i = 0; while (i < 1000) { _printf("{} + {} = {}\n", i, 1, i + 1); i = i + 1; })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+TL_BENCH(number_to_string) {
+	auto script = tl_bench::Script{};
+	auto const program = script.compile(R"(var i = 0; while (i < 1000) { _str(i / 7); i = i + 1; })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+TL_BENCH(string_to_number) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(var text = _str(1 / 7);)");
+	auto const program = script.compile(R"(var i = 0; while (i < 1000) { _num(text); i = i + 1; })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+namespace {
+// a module of many small functions: what an import costs to parse vs load compiled
+std::string make_module() {
+	auto ret = std::string{};
+	for (auto i = 0; i < 500; ++i) {
+		auto const n = std::to_string(i);
+		ret += "fn f" + n + "(x) {\n\tvar y = x + " + n + ";\n\tif (y > 10) { return y * 2; }\n\treturn \"s" + n + "\";\n}\n";
+	}
+	return ret;
+}
+
+void import_module(tl_bench::State& state, bool const cached) {
+	auto const dir = std::filesystem::temp_directory_path() / "tl-bench-modules";
+	std::filesystem::create_directories(dir);
+	toylang::util::write_file((dir / "big.tl").string().c_str(), make_module());
+	std::filesystem::remove(dir / "big.tlc");
+	state.run([&] {
+		auto in = toylang::Interpreter{};
+		in.media.mount(dir.string());
+		in.cache.modules = cached;
+		in.execute({.text = R"(import "big.tl";)"});
+	});
+	std::filesystem::remove_all(dir);
+}
+} // namespace
+
+TL_BENCH(import_parsed) { import_module(state, false); }
+TL_BENCH(import_compiled_cache) { import_module(state, true); }
+
+namespace {
+void boot(tl_bench::State& state, bool const embedded) {
+	state.run([&] {
+		auto in = toylang::Interpreter{};
+		if (embedded) {
+			in.media.embedded = toylang::stdlib::files();
+		} else {
+			in.media.mount(TL_STDLIB_DIR);
+		}
+		in.execute({.text = R"(import "std.tl";)"});
+	});
+}
+} // namespace
+
+TL_BENCH(boot_stdlib_from_disk) { boot(state, false); }
+TL_BENCH(boot_stdlib_embedded) { boot(state, true); }
+
+namespace {
+// the same compiled program run by one instance per thread: throughput should scale with threads
+void shared_program(tl_bench::State& state, std::size_t const threads) {
+	auto script = tl_bench::Script{};
+	auto const image = script.in.snapshot();
+	auto const program = script.compile(R"(var i = 0; var total = 0; while (i < 10000) { total = total + i * 2; i = i + 1; })");
+	state.run(
+		[&] {
+			auto workers = std::vector<std::jthread>{};
+			for (std::size_t t = 0; t < threads; ++t) {
+				workers.emplace_back([&] {
+					auto in = toylang::Interpreter{image};
+					in.execute(program);
+				});
+			}
+		},
+		threads);
+}
+} // namespace
+
+TL_BENCH(shared_program_1_thread) { shared_program(state, 1); }
+TL_BENCH(shared_program_all_threads) { shared_program(state, std::max(std::thread::hardware_concurrency(), 1U)); }
+
+// each spawn deep copies the globals: a few hundred list nodes make that cost visible
+TL_BENCH(spawn_join) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(var table = list_make(0); var i = 1; while (i < 200) { list_push_back(table, i); i = i + 1; } fn id(x) { return x; })");
+	auto const program = script.compile(R"(var i = 0; while (i < 100) { _join(_spawn(id, i)); i = i + 1; })");
+	state.run([&] { script.execute(program); }, 100);
+}
+
+// one producer task, the main script receiving: the queue is smaller than the stream, so both sides block
+TL_BENCH(channel_send_recv) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(fn produce(ch, n) { var i = 0; while (i < n) { _send(ch, i); i = i + 1; } _close(ch); })");
+	auto const program = script.compile(R"(
+var ch = _channel(64);
+var task = _spawn(produce, ch, 1000);
+var value = _recv(ch);
+while (value != null) { value = _recv(ch); }
+_join(task);
+)");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+// resuming a parked generator vs the same loop inline
+TL_BENCH(generator_next) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(fn count_up(n) { var i = 0; while (i < n) { yield i; i = i + 1; } })");
+	auto const program = script.compile(R"(var it = count_up(1000); var total = 0; while (!_done(it)) { var value = _next(it); if (value != null) { total = total + value; } })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+TL_BENCH(generator_inline_loop) {
+	auto script = tl_bench::Script{};
+	auto const program = script.compile(R"(var i = 0; var total = 0; while (i < 1000) { total = total + i; i = i + 1; })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+namespace {
+// 1 MiB of text without the needle's first byte until the very end: items are bytes scanned
+std::string const& haystack() {
+	static auto const ret = [] {
+		auto ret = std::string{};
+		while (ret.size() < 1024 * 1024) { ret += "the quick brown fox jumps over the lazy dog\n"; }
+		return ret + "XYZ";
+	}();
+	return ret;
+}
+} // namespace
+
+TL_BENCH(str_find_1mib) {
+	auto const& text = haystack();
+	state.run([&] { tl_bench::keep(toylang::util::find(text, "XYZ")); }, text.size());
+}
+
+TL_BENCH(str_find_1mib_std) {
+	auto const text = std::string_view{haystack()};
+	state.run([&] { tl_bench::keep(text.find("XYZ")); }, text.size());
+}
+
+TL_BENCH(str_count_1mib) {
+	auto const& text = haystack();
+	state.run([&] { tl_bench::keep(toylang::util::count(text, "fox")); }, text.size());
+}
+
+TL_BENCH(str_split_script) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(var line = "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota,kappa"; fn len_sum(total, part) { return total + _len(part); })");
+	auto const program = script.compile(R"(var i = 0; while (i < 100) { _reduce(_split(line, ","), len_sum, 0); i = i + 1; })");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+namespace {
+// 64 KiB of text, with an escape every escape_every bytes (0: none): items are input bytes
+void unescape(tl_bench::State& state, std::size_t const escape_every) {
+	auto text = std::string{};
+	while (text.size() < 64 * 1024) {
+		text += escape_every == 0 ? std::string(64, 'x') : std::string(escape_every, 'x');
+		if (escape_every > 0) { text += "\\n"; }
+	}
+	state.run([&] { tl_bench::keep(toylang::util::unescape(text)); }, text.size());
+}
+} // namespace
+
+TL_BENCH(unescape_plain) { unescape(state, 0); }
+TL_BENCH(unescape_sparse) { unescape(state, 62); }
+TL_BENCH(unescape_dense) { unescape(state, 6); }
+
+namespace {
+// a 1000 node list (prev / next links, string and number values): items are nodes
+void make_list(tl_bench::Script& script) {
+	script.execute(R"(var list = list_make(0); var i = 1; while (i < 1000) { list_push_back(list, "node value " + _str(i)); i = i + 1; } var bytes = _serialize(list);)");
+}
+} // namespace
+
+TL_BENCH(serialize_list) {
+	auto script = tl_bench::Script{};
+	make_list(script);
+	auto const program = script.compile(R"(_serialize(list);)");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+TL_BENCH(deserialize_list) {
+	auto script = tl_bench::Script{};
+	make_list(script);
+	auto const program = script.compile(R"(_deserialize(bytes);)");
+	state.run([&] { script.execute(program); }, 1000);
+}
+
+// numbers as strings ("0", "1", "10", "100", ...) are far from sorted: made natively, so the run is mostly the sort
+TL_BENCH(sort_default_100k) {
+	auto script = tl_bench::Script{};
+	auto const program = script.compile(R"(_sort(_map(_range(0, 100000), _str));)");
+	state.run([&] { script.execute(program); }, 100000);
+}
+
+TL_BENCH(sort_comparator_10k) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(fn less(a, b) { return a < b; })");
+	auto const program = script.compile(R"(_sort(_map(_range(0, 10000), _str), less);)");
+	state.run([&] { script.execute(program); }, 10000);
+}
+
+namespace {
+// a pricing rule per record: host values bound to its names
+constexpr std::string_view rule_v{"vip and price * 0.9 > floor or price > limit"};
+} // namespace
+
+TL_BENCH(expression_compiled) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(var floor = 10; var limit = 100;)");
+	auto const names = std::array<std::string_view, 2>{"price", "vip"};
+	auto const expr = script.in.compile_expr(rule_v, names);
+	auto bindings = std::array<toylang::Value, 2>{toylang::Value{.payload = 0.0}, toylang::Value{.payload = toylang::Bool{true}}};
+	state.run(
+		[&] {
+			for (auto i = 0; i < 1000; ++i) {
+				bindings[0].payload = static_cast<double>(i);
+				tl_bench::keep(script.in.evaluate(expr, bindings));
+			}
+		},
+		1000);
+}
+
+TL_BENCH(expression_text) {
+	// the same rule re-parsed (and printed) every time, bindings as globals
+	auto script = tl_bench::Script{};
+	script.execute(R"(var floor = 10; var limit = 100; var price = 0; var vip = true;)");
+	state.run(
+		[&] {
+			for (auto i = 0; i < 1000; ++i) {
+				script.output.clear();
+				script.in.evaluate(rule_v);
+			}
+		},
+		1000);
+}
+
+namespace {
+// 64Ki records for the rule above, as host columns
+struct Records {
+	std::vector<double> prices{};
+	std::vector<std::uint8_t> vips{};
+
+	Records() {
+		for (std::size_t i = 0; i < 64 * 1024; ++i) {
+			prices.push_back(static_cast<double>(i % 200));
+			vips.push_back(static_cast<std::uint8_t>(i % 3 == 0));
+		}
+	}
+};
+} // namespace
+
+TL_BENCH(expression_batch) {
+	auto script = tl_bench::Script{};
+	script.execute(R"(var floor = 10; var limit = 100;)");
+	auto const names = std::array<std::string_view, 2>{"price", "vip"};
+	auto const expr = script.in.compile_expr(rule_v, names);
+	auto const records = Records{};
+	auto const columns = std::array<toylang::batch::Column, 2>{std::span<double const>{records.prices}, std::span<std::uint8_t const>{records.vips}};
+	auto out = toylang::batch::Output{};
+	state.run([&] { script.in.evaluate(expr, columns, out); }, records.prices.size());
+}
+
+TL_BENCH(expression_batch_rows) {
+	// the same records one evaluate() each
+	auto script = tl_bench::Script{};
+	script.execute(R"(var floor = 10; var limit = 100;)");
+	auto const names = std::array<std::string_view, 2>{"price", "vip"};
+	auto const expr = script.in.compile_expr(rule_v, names);
+	auto const records = Records{};
+	auto bindings = std::array<toylang::Value, 2>{};
+	state.run(
+		[&] {
+			for (std::size_t i = 0; i < records.prices.size(); ++i) {
+				bindings[0].payload = records.prices[i];
+				bindings[1].payload = toylang::Bool{records.vips[i] != 0};
+				tl_bench::keep(script.in.evaluate(expr, bindings));
+			}
+		},
+		records.prices.size());
+}
@@ -0,0 +1,16 @@
+# Generates a C++ header embedding each file in INPUTS as constant data, written to OUTPUT.
+# Usage: cmake -D "INPUTS=a.tl;b.tl" -D OUTPUT=embedded.hpp -P embed_files.cmake
+
+set(content "#pragma once\n// Generated by embed_files.cmake: do not edit\n#include <toylang/media.hpp>\n\nnamespace toylang::embedded {\n")
+set(table "")
+set(index 0)
+foreach(input IN LISTS INPUTS)
+  get_filename_component(name "${input}" NAME)
+  file(READ "${input}" hex HEX)
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "char(0x\\1)," bytes "${hex}")
+  string(APPEND content "inline constexpr char file_${index}_v[] = {${bytes}char(0x00)};\n")
+  string(APPEND table "\t{\"${name}\", {file_${index}_v, sizeof(file_${index}_v) - 1}},\n")
+  math(EXPR index "${index} + 1")
+endforeach()
+string(APPEND content "\ninline constexpr Media::Embedded files_v[] = {\n${table}};\n} // namespace toylang::embedded\n")
+file(WRITE "${OUTPUT}" "${content}")
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace toylang {
+///
+/// \brief Column-at-a-time evaluation of a compiled expression over host arrays (see Interpreter::evaluate)
+///
+namespace batch {
+///
+/// \brief Values bound to one name: an entry per row (bools are 0 / 1)
+///
+using Column = std::variant<std::span<double const>, std::span<std::uint8_t const>, std::span<std::string_view const>>;
+
+///
+/// \brief Result per row. Strings view the input columns / the expression's literals, or storage (string globals and strings built by the evaluation).
+///
+struct Output {
+	std::variant<std::vector<double>, std::vector<std::uint8_t>, std::vector<std::string_view>> values{};
+	std::deque<std::string> storage{};
+};
+} // namespace batch
+} // namespace toylang
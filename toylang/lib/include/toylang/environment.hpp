@@ -13,14 +13,35 @@ class Environment {
   public:
 	class Scope;
 	class Frame;
+	class Suspended;
 
 	Environment();
 
+	///
+	/// \brief Copy with struct instances detached from this environment (sharing between them is preserved).
+	/// Generators, iterators and files are not copied: they are null handles in the copy (see detach()).
+	///
+	Environment clone() const;
+	///
+	/// \brief Like clone(), but of the global scope alone (all that a function call can see)
+	///
+	Environment clone_globals() const;
+
 	bool assign(std::string_view const& key, Value value);
 	bool define(std::string_view key, Value value);
 	Value* find(std::string_view const& key);
 
 	std::size_t depth() const { return m_book.size(); }
+	///
+	/// \brief Number of values bound in every scope of every frame (suspended frames excluded)
+	///
+	std::size_t size() const;
+
+	///
+	/// \brief Move the active call frame (and its scopes) off the stack / back on top: no pages are copied
+	///
+	void suspend(Suspended& out);
+	void resume(Suspended& frame);
 
   private:
 	using Page = std::unordered_map<std::string_view, Value>;
@@ -37,6 +58,15 @@ class Environment {
 	void pop_frame();
 
 	std::vector<Chapter> m_book{};
+
+	friend class Interpreter;
+};
+
+class Environment::Suspended {
+  private:
+	Chapter m_chapter{};
+
+	friend class Environment;
 };
 
 class Environment::Scope {
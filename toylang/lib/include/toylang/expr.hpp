@@ -34,8 +34,10 @@ struct ArgsArray {
 struct ExprLiteral : Expr {
 	Literal value;
 	Token self;
+	// string literals: escapes processed once, when parsed (shared by every evaluation)
+	std::shared_ptr<std::string const> text{};
 
-	ExprLiteral(Literal value, Token self) : value{std::move(value)}, self(std::move(self)) {}
+	ExprLiteral(Literal value, Token self);
 	Value accept(Visitor& out) const override final;
 };
 
@@ -1,38 +1,154 @@
 #pragma once
+#include <toylang/batch.hpp>
 #include <toylang/environment.hpp>
 #include <toylang/media.hpp>
 #include <toylang/source.hpp>
 #include <toylang/stmt.hpp>
+#include <toylang/util/arena.hpp>
 #include <toylang/util/buffer.hpp>
 #include <toylang/util/reporter.hpp>
+#include <toylang/util/text_buf.hpp>
+#include <chrono>
+#include <functional>
 
 namespace toylang {
+struct Memoized;
+
 class Interpreter {
   public:
 	enum : std::uint32_t { ePrintStmtExprs = 1 << 0 };
 	using Debug = std::uint32_t;
+	using Clock = std::chrono::steady_clock;
+
+	///
+	/// \brief Compiled module cache (.tlc) for imports: written next to each source, or into directory if set
+	///
+	struct Cache {
+		bool modules{};
+		std::string directory{};
+	};
+
+	///
+	/// \brief Per-request storage usage (since construction / the last reset)
+	///
+	///
+	/// \brief What an instance holds since its construction / last reset (a pool lease's checkout)
+	///
+	struct Stats {
+		// request arena: copies of source text (mapped files are not copied)
+		util::Arena::Stats arena{};
+		std::size_t mapped{};
+		std::size_t statements{};
+		// values bound in the environment (on the heap, not in the arena): globals are re-cloned from the image on every reset
+		std::size_t values{};
+	};
+
+	class Image;
+	class Program;
+	class Expression;
 
 	Interpreter(std::unique_ptr<util::Notifier> custom = {});
+	///
+	/// \brief Clone a new instance from a snapshot: no intrinsics / imports are re-run
+	///
+	Interpreter(Image const& image, std::unique_ptr<util::Notifier> custom = {});
+	///
+	/// \brief Like Interpreter(Image const&), but takes image's globals instead of cloning them
+	///
+	Interpreter(Image&& image, std::unique_ptr<util::Notifier> custom = {});
 
 	Interpreter& operator=(Interpreter&&) = delete;
+	///
+	/// \brief Waits for every task spawned by this instance (they may refer to its storage)
+	///
+	~Interpreter();
 
 	bool execute(Source program);
+	bool execute_file(char const* path);
+	///
+	/// \brief Like execute_or_evaluate: a file that is a single expression prints its value
+	///
+	bool execute_or_evaluate_file(char const* path);
+	///
+	/// \brief Parse source into a Program that any number of Interpreters (on any threads) can execute
+	///
+	Program compile(Source source);
+	bool execute(Program const& program);
 	bool evaluate(std::string_view expression);
+	///
+	/// \brief Parse expression once, to be evaluated any number of times with host values bound to names (in that order)
+	///
+	Expression compile_expr(std::string_view expression, std::span<std::string_view const> names = {});
+	///
+	/// \brief Evaluate a compiled expression without printing: bindings are values for its names, visible to it alone (not to functions it calls).
+	/// Returns null on error (reported, see is_errored()): later calls evaluate regardless.
+	///
+	Value evaluate(Expression const& expression, std::span<Value const> bindings = {});
+	///
+	/// \brief Evaluate a compiled expression for every row of columns (bound to its names, like bindings above) into out.
+	/// Arithmetic / comparisons / logic over the columns run a chunk of rows at a time; anything else (calls, fields, ...) runs row by row.
+	///
+	bool evaluate(Expression const& expression, std::span<batch::Column const> columns, batch::Output& out);
 	bool execute_or_evaluate(Source source);
 
 	Environment& environment() { return m_environment; }
 
+	///
+	/// \brief Call callee(args...) on the runtime's scheduler in a clone of this instance's globals (args are deep copied).
+	/// Every spawn deep copies all the globals (struct instances; not functions / strings' text): O(their size) per task,
+	/// so large data shared by many tasks is better passed once per task as an argument, or split with for_each (one clone for all its calls).
+	///
+	Task spawn(Token const& at, Value const& callee, std::span<Value const> args);
+	///
+	/// \brief Call callee(item) for each item in parallel, then join all of them in order
+	///
+	bool for_each(Token const& at, Value const& callee, std::span<Value const> items);
+	///
+	/// \brief Wait for task (running it here if no worker has started it yet), forward its output and return its result
+	///
+	Value join(Token const& at, Task const& task);
+	///
+	/// \brief Run generator until its next yield (returns the yielded value) or its end (returns its return value / null)
+	///
+	Value resume(Token const& at, Generator const& generator);
+
 	void runtime_error(Token const& at, std::string_view message) const;
+	bool is_errored() const { return m_reporter->error(); }
+	///
+	/// \brief Redirect script output / diagnostics into strings (stdout / stderr when null)
+	///
+	void redirect(std::string* output, std::string* diagnostics);
+	void write(std::string_view text) const;
 	void clear_state();
+	///
+	/// \brief Freeze all parsed sources and statements so far (shared with clones) and capture globals
+	///
+	Image snapshot();
+	///
+	/// \brief Return to image's state: request storage is rewound (arena reset in O(1)), globals are re-cloned
+	///
+	void reset(Image const& image);
+	Stats stats() const;
 
 	Media media{};
+	Cache cache{};
 	Debug debug{};
+	///
+	/// \brief Loops and function calls raise a runtime error once this passes
+	///
+	Clock::time_point deadline{Clock::time_point::max()};
+	///
+	/// \brief Called after script output is appended to the redirected string: may consume it (stream it out and clear it)
+	///
+	std::function<void(std::string& output)> on_output{};
 
   private:
 	struct Eval;
 	struct Exec;
+	struct Resume;
 	struct Storage {
-		std::vector<util::CharBuf> texts{};
+		util::Arena arena{};
+		std::vector<util::TextBuf> texts{};
 		std::vector<UStmt> executed{};
 		std::vector<std::string> imported{};
 
@@ -40,11 +156,20 @@ class Interpreter {
 			texts.clear();
 			executed.clear();
 			imported.clear();
+			arena.reset();
 		}
 	};
 
+	void tick(Token const& at);
+	Image image(Environment environment) const;
+	Task spawn(std::shared_ptr<Image> image, Token const& at, Value const& callee, std::span<Value const> args);
+	void settle();
+	static void run(Task::State& task);
+	bool execute_stored(Source program, char const* cache_path = {});
+	bool run_file(char const* path, bool evaluate_expression);
+	void execute_stmt(UStmt&& stmt);
+	void execute_stmt(Stmt const& stmt);
 	bool execute_import(Token const& path);
-	bool is_errored() const { return m_reporter->error(); }
 	bool define(Token const& name, Value value);
 	bool assign(Token const& name, Value value);
 
@@ -52,10 +177,73 @@ class Interpreter {
 	void add_intrinsic();
 	void add_intrinsics();
 	Source store(Source source);
+	Source store(util::TextBuf&& text, std::string_view filename);
 	Stmt& store(UStmt&& stmt);
 
 	std::unique_ptr<util::Reporter> m_reporter{};
+	std::string* m_output{};
+	std::uint32_t m_ticks{};
+	std::uint32_t m_depth{};
+	std::vector<std::shared_ptr<Storage const>> m_frozen{};
+	std::vector<Task> m_tasks{};
+	// bindings of the last evaluated Expression (see evaluate())
+	struct {
+		Environment::Suspended frame{};
+		std::vector<std::string> names{};
+		bool suspended{};
+	} m_bound{};
+	Value m_returned{};
 	Storage m_storage{};
 	Environment m_environment{};
+
+	friend struct Task::State;
+	friend struct Memoized;
+};
+
+///
+/// \brief Parsed source and statements: immutable, and safe to share between Interpreters running on different threads
+///
+class Interpreter::Program {
+  public:
+	explicit operator bool() const { return m_storage != nullptr; }
+
+  private:
+	std::shared_ptr<Storage const> m_storage{};
+	std::vector<Token> m_imports{};
+
+	friend class Interpreter;
+};
+
+///
+/// \brief Parsed expression and its binding names: immutable, and safe to share between Interpreters running on different threads
+///
+class Interpreter::Expression {
+  public:
+	explicit operator bool() const { return m_expr != nullptr; }
+
+	std::span<std::string_view const> names() const { return m_names; }
+
+  private:
+	// source text and names
+	std::shared_ptr<Storage const> m_storage{};
+	std::shared_ptr<Expr const> m_expr{};
+	std::vector<std::string_view> m_names{};
+
+	friend class Interpreter;
+};
+
+///
+/// \brief Snapshot of an initialized Interpreter: immutable sources / AST are shared, globals are deep copied per clone
+///
+class Interpreter::Image {
+  private:
+	std::vector<std::shared_ptr<Storage const>> m_frozen{};
+	Environment m_environment{};
+	std::vector<std::string> m_imported{};
+	Media m_media{};
+	Cache m_cache{};
+	Debug m_debug{};
+
+	friend class Interpreter;
 };
 } // namespace toylang
@@ -0,0 +1,52 @@
+#pragma once
+#include <toylang/interpreter.hpp>
+#include <mutex>
+
+namespace toylang {
+///
+/// \brief Hands out Interpreters restored to a baseline Image; released instances are reset and reused
+///
+class InterpreterPool {
+  public:
+	class Lease;
+
+	explicit InterpreterPool(Interpreter::Image image) : m_image(std::move(image)) {}
+
+	Lease acquire();
+	std::size_t idle() const;
+	std::size_t created() const;
+
+  private:
+	Interpreter::Stats release(std::unique_ptr<Interpreter>&& interpreter);
+
+	Interpreter::Image m_image;
+	std::vector<std::unique_ptr<Interpreter>> m_idle{};
+	std::size_t m_created{};
+	mutable std::mutex m_mutex{};
+};
+
+class InterpreterPool::Lease {
+  public:
+	Lease() = default;
+	Lease(Lease&&) = default;
+	Lease& operator=(Lease&& rhs) noexcept;
+	~Lease() { release(); }
+
+	Interpreter& get() const { return *m_interpreter; }
+	Interpreter* operator->() const { return m_interpreter.get(); }
+	explicit operator bool() const { return m_interpreter != nullptr; }
+
+	///
+	/// \brief Return the interpreter to the pool; returns the storage used during this lease
+	///
+	Interpreter::Stats release();
+
+  private:
+	Lease(InterpreterPool& pool, std::unique_ptr<Interpreter>&& interpreter) : m_pool(&pool), m_interpreter(std::move(interpreter)) {}
+
+	InterpreterPool* m_pool{};
+	std::unique_ptr<Interpreter> m_interpreter{};
+
+	friend class InterpreterPool;
+};
+} // namespace toylang
@@ -1,14 +1,42 @@
 #pragma once
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace toylang {
+///
+/// \brief Mounted directories and URI lookup.
+/// Resolved paths (and optionally file contents, up to a total size) are cached per mount set, and validated against each file's
+/// inode / size / mtime and against earlier mounts (a file added there shadows the cached one).
+/// Copies of a Media share the same cache.
+/// Embedded files are served from memory and take precedence over mounted directories.
+///
 struct Media {
+	struct Cache;
+	struct Embedded {
+		std::string_view uri{};
+		std::string_view text{};
+	};
+
+	std::span<Embedded const> embedded{};
 	std::vector<std::string> mounted{};
+	std::shared_ptr<Cache> cache{};
+	bool cache_contents{};
+
+	Media();
 
 	bool mount(std::string_view path);
 	bool is_mounted(std::string_view path) const;
 	bool exists(std::string_view uri) const;
+	///
+	/// \brief Text of the embedded file uri (which may be empty), nullopt if there is none
+	///
+	std::optional<std::string_view> find_embedded(std::string_view uri) const;
+	std::string resolve(std::string_view uri) const;
 	bool read_to(std::string& out, std::string_view uri) const;
+	void clear_cache() const;
 };
 } // namespace toylang
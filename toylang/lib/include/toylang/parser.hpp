@@ -23,7 +23,7 @@ class Parser {
 	Token const& current() const { return m_current; }
 
   private:
-	enum : std::uint32_t { eScoped = 1 << 0 };
+	enum : std::uint32_t { eScoped = 1 << 0, eInFn = 1 << 1, eYielded = 1 << 2 };
 	struct Scope;
 
 	UExpr equality();
@@ -50,6 +50,7 @@ class Parser {
 	UPtr<StmtBreak> stmt_break();
 	UPtr<StmtReturn> stmt_return();
 	UPtr<StmtIf> stmt_if();
+	UPtr<StmtYield> stmt_yield();
 
 	std::vector<UStmt> make_block();
 	UExpr finish_invoke(UExpr&& callee);
@@ -58,16 +58,10 @@ class Scanner {
 		return make_token(type, m_current.full_text.substr(m_current.char_span.first, m_current.char_span.last - m_current.char_span.first), m_current);
 	}
 
-	constexpr bool munch(Token& out, std::string_view const keyword, TokenType type) {
-		if (m_current.full_text.size() < m_current.char_span.first + keyword.size()) { return false; }
-		if (m_current.full_text.substr(m_current.char_span.first, keyword.size()) != keyword) { return false; }
-		m_current.char_span.last = m_current.char_span.first + keyword.size();
-		out = make_token(type);
-		return true;
-	}
-
 	constexpr bool make_string(Token& out) {
 		while (peek() != '\"' && !at_end()) {
+			// an escaped character (eg \") doesn't end the string: escapes are processed by ExprLiteral
+			if (peek() == '\\' && peek_next() != '\0') { advance(); }
 			if (peek() == '\n') { ++m_current.line; }
 			advance();
 		}
@@ -96,12 +90,16 @@ class Scanner {
 	}
 
 	constexpr Token make_identifier() {
-		auto ret = Token{};
+		while (!at_end() && match_identifier(peek())) { advance(); }
+		auto ret = make_token(TokenType::eIdentifier);
+		// whole words only: for_each is an identifier, not 'for' followed by '_each'
 		for (TokenType type = keyword_range_v.first; type < keyword_range_v.second; type = increment(type)) {
-			if (munch(ret, token_string(type), type)) { return ret; }
+			if (ret.lexeme == token_string(type)) {
+				ret.type = type;
+				break;
+			}
 		}
-		while (!at_end() && match_identifier(peek())) { advance(); }
-		return make_token(TokenType::eIdentifier);
+		return ret;
 	}
 
 	constexpr bool try_single(Token& out, char const c) {
@@ -0,0 +1,9 @@
+#pragma once
+#include <toylang/media.hpp>
+
+namespace toylang::stdlib {
+///
+/// \brief stdlib/*.tl, embedded into the library at build time
+///
+std::span<Media::Embedded const> files();
+} // namespace toylang::stdlib
@@ -77,8 +77,13 @@ struct StmtFn : Stmt {
 	Token name;
 	Params params;
 	std::vector<UStmt> body;
+	///
+	/// \brief Body contains a yield: calls return a Generator instead of running it
+	///
+	bool generator{};
 
-	StmtFn(Token name, Params&& params, std::vector<UStmt>&& body) : name{std::move(name)}, params{std::move(params)}, body{std::move(body)} {}
+	StmtFn(Token name, Params&& params, std::vector<UStmt>&& body, bool generator = false)
+		: name{std::move(name)}, params{std::move(params)}, body{std::move(body)}, generator{generator} {}
 	void accept(Visitor& out) const override final;
 };
 
@@ -93,6 +98,14 @@ struct StmtReturn : Stmt {
 	void accept(Visitor& out) const override final;
 };
 
+struct StmtYield : Stmt {
+	Token token;
+	UExpr value{};
+
+	StmtYield(Token token, UExpr&& value) : token{std::move(token)}, value{std::move(value)} {}
+	void accept(Visitor& out) const override final;
+};
+
 struct StmtStruct : Stmt {
 	Token name;
 	std::vector<UPtr<StmtVar>> vars{};
@@ -111,5 +124,6 @@ struct Stmt::Visitor {
 	virtual void visit(StmtFn const& stmt) = 0;
 	virtual void visit(StmtReturn const& stmt) = 0;
 	virtual void visit(StmtStruct const& stmt) = 0;
+	virtual void visit(StmtYield const& stmt) = 0;
 };
 } // namespace toylang
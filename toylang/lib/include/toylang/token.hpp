@@ -45,6 +45,7 @@ enum class TokenType {
 	eBreak,
 	eStruct,
 	eImport,
+	eYield,
 
 	eEof,
 
@@ -56,7 +57,7 @@ inline constexpr std::pair<TokenType, TokenType> keyword_range_v = {TokenType::e
 inline constexpr std::string_view token_str_v[] = {
 	"+",  "-",	 "*",	  "/",	",",	".",	";",		  "{",		"}",	  "(",	   ")",		 "!",	   "!=",
 	"=",  "==",	 ">",	  ">=", "<",	"<=",	"identifier", "number", "string", "and",   "or",	 "true",   "false",
-	"fn", "for", "while", "if", "else", "null", "return",	  "this",	"var",	  "break", "struct", "import", "eof",
+	"fn", "for", "while", "if", "else", "null", "return",	  "this",	"var",	  "break", "struct", "import", "yield", "eof",
 };
 static_assert(std::size(token_str_v) == static_cast<std::size_t>(TokenType::eCOUNT_));
 
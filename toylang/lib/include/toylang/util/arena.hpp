@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace toylang::util {
+///
+/// \brief Bump allocator: individual allocations are never freed, reset() rewinds to the first chunk in O(1) (chunks are retained)
+///
+class Arena {
+  public:
+	struct Stats {
+		std::size_t allocations{};
+		std::size_t bytes{};
+		std::size_t reserved{};
+	};
+
+	static constexpr std::size_t chunk_size_v{16 * 1024};
+
+	explicit Arena(std::size_t chunk_size = chunk_size_v) : m_chunk_size(chunk_size) {}
+
+	void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+	std::string_view copy(std::string_view str);
+	void reset();
+
+	Stats const& stats() const { return m_stats; }
+
+  private:
+	struct Chunk {
+		std::unique_ptr<std::byte[]> data{};
+		std::size_t size{};
+	};
+
+	std::vector<Chunk> m_chunks{};
+	std::size_t m_chunk_size{};
+	std::size_t m_index{};
+	std::size_t m_offset{};
+	Stats m_stats{};
+};
+} // namespace toylang::util
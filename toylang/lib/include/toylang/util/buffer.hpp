@@ -30,6 +30,7 @@ class Buffer {
 ///
 class CharBuf : public Buffer<char> {
   public:
+	CharBuf() = default;
 	CharBuf(std::string_view str) : Buffer<char>{{str.data(), str.size()}} {}
 	std::string_view view() const { return {data(), size()}; }
 	operator std::string_view() const { return view(); }
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace toylang::util {
+///
+/// \brief Streams a file through a reusable buffer: lines / chunks are views into it.
+/// A view stays valid as long as buffer() is held: once that is shared the reader continues in a fresh buffer instead of overwriting it.
+/// Memory use is the buffer size (grown only to fit a single line longer than it) plus buffers still referenced, regardless of file size.
+///
+class FileReader {
+  public:
+	static constexpr std::size_t buffer_size_v{1024 * 1024};
+
+	FileReader() = default;
+	explicit FileReader(char const* path, std::size_t buffer_size = buffer_size_v);
+	FileReader(FileReader&& rhs) noexcept;
+	FileReader& operator=(FileReader&& rhs) noexcept;
+	~FileReader() noexcept { close(); }
+
+	explicit operator bool() const { return m_file != nullptr; }
+
+	///
+	/// \brief Next line without its terminator (\n or \r\n); false at end of file
+	///
+	bool read_line(std::string_view& out);
+	///
+	/// \brief Up to max bytes (bounded by the buffer size); false at end of file
+	///
+	bool read_chunk(std::string_view& out, std::size_t max);
+	void close() noexcept;
+
+	std::size_t capacity() const { return m_capacity; }
+	///
+	/// \brief Buffer that views returned by the last read point into
+	///
+	std::shared_ptr<std::string const> buffer() const { return m_buffer; }
+
+  private:
+	bool fill();
+
+	std::FILE* m_file{};
+	std::shared_ptr<std::string> m_buffer{};
+	std::size_t m_capacity{};
+	std::size_t m_begin{};
+	std::size_t m_end{};
+	bool m_eof{};
+};
+} // namespace toylang::util
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace toylang::util {
+///
+/// \brief Bounded lock-free multi producer / multi consumer queue (sequence numbered ring)
+///
+template <typename Type>
+class MpmcQueue {
+  public:
+	///
+	/// \brief Holds at most capacity values (at least 1); the ring itself is a power of two
+	///
+	explicit MpmcQueue(std::size_t capacity)
+		: m_cells(std::make_unique<Cell[]>(ring_size(capacity))), m_mask(ring_size(capacity) - 1), m_capacity(capacity < 1 ? 1 : capacity) {
+		for (std::size_t i = 0; i <= m_mask; ++i) { m_cells[i].sequence.store(i, std::memory_order_relaxed); }
+	}
+
+	MpmcQueue& operator=(MpmcQueue&&) = delete;
+
+	std::size_t capacity() const { return m_capacity; }
+
+	///
+	/// \brief Moves from value only on success (false: full)
+	///
+	bool try_push(Type& value) {
+		auto pos = m_enqueue.load(std::memory_order_relaxed);
+		while (true) {
+			auto& cell = m_cells[pos & m_mask];
+			auto const seq = cell.sequence.load(std::memory_order_acquire);
+			auto const diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				// a ring larger than capacity is full before its cells run out (m_dequeue only grows: a stale read errs towards full)
+				if (m_capacity <= m_mask && static_cast<std::ptrdiff_t>(pos - m_dequeue.load(std::memory_order_acquire)) >= static_cast<std::ptrdiff_t>(m_capacity)) {
+					return false;
+				}
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					cell.value = std::move(value);
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	///
+	/// \brief false: empty
+	///
+	bool try_pop(Type& out) {
+		auto pos = m_dequeue.load(std::memory_order_relaxed);
+		while (true) {
+			auto& cell = m_cells[pos & m_mask];
+			auto const seq = cell.sequence.load(std::memory_order_acquire);
+			auto const diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+			if (diff == 0) {
+				if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					out = std::move(cell.value);
+					cell.value = Type{};
+					cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_dequeue.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+  private:
+	static constexpr std::size_t line_v{64};
+
+	struct Cell {
+		std::atomic<std::size_t> sequence{};
+		Type value{};
+	};
+
+	static constexpr std::size_t ring_size(std::size_t const capacity) { return std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity); }
+
+	std::unique_ptr<Cell[]> m_cells{};
+	std::size_t m_mask{};
+	std::size_t m_capacity{};
+	// producers and consumers on separate cache lines
+	alignas(line_v) std::atomic<std::size_t> m_enqueue{};
+	alignas(line_v) std::atomic<std::size_t> m_dequeue{};
+};
+} // namespace toylang::util
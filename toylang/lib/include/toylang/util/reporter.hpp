@@ -1,5 +1,6 @@
 #pragma once
 #include <toylang/util/notifier.hpp>
+#include <string>
 
 namespace toylang::util {
 ///
@@ -10,10 +11,19 @@ class Reporter : public Notifier {
 	Reporter(std::unique_ptr<Notifier> next) : Notifier{std::move(next)} {}
 
 	void set_error() { m_data.error = true; }
+	void clear_error() { m_data.error = false; }
 	bool error() const { return m_data.error; }
+	///
+	/// \brief Pass on diagnostics already formatted elsewhere (eg by another Reporter)
+	///
+	void forward(std::string_view formatted);
 
 	char quote = '\'';
 	char mark = '^';
+	///
+	/// \brief If set, formatted diagnostics are appended here instead of being printed
+	///
+	std::string* capture{};
 
   private:
 	void on_notify(Diagnostic const& diag) override;
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace toylang::util {
+inline constexpr std::size_t npos_v = std::string_view::npos;
+
+///
+/// \brief Offset of the first needle in haystack at or after from (npos_v if absent).
+/// Blocks of candidates are filtered on the needle's first and last bytes (SSE2 where available) before comparing.
+///
+std::size_t find(std::string_view haystack, std::string_view needle, std::size_t from = 0);
+///
+/// \brief Offset of the last needle in haystack (npos_v if absent)
+///
+std::size_t rfind(std::string_view haystack, std::string_view needle);
+///
+/// \brief Number of non-overlapping needles in haystack (0 for an empty needle)
+///
+std::size_t count(std::string_view haystack, std::string_view needle);
+///
+/// \brief haystack with every (non-overlapping) from replaced by to
+///
+std::string replace(std::string_view haystack, std::string_view from, std::string_view to);
+///
+/// \brief str without leading / trailing whitespace
+///
+std::string_view trim(std::string_view str);
+} // namespace toylang::util
@@ -0,0 +1,40 @@
+#pragma once
+#include <toylang/util/buffer.hpp>
+#include <cstdint>
+#include <string_view>
+
+namespace toylang::util {
+///
+/// \brief Immutable source text: either a read-only file mapping or an owned copy
+///
+class TextBuf {
+  public:
+	enum : std::uint32_t { eSequential = 1 << 0 };
+	using Hints = std::uint32_t;
+
+	///
+	/// \brief Map path read-only (falls back to reading into memory where mapping is unavailable: pipes, /dev/stdin, ...).
+	/// The result is false if path could not be opened or read; an empty file is true.
+	///
+	static TextBuf map(char const* path, Hints hints = {});
+
+	TextBuf() = default;
+	TextBuf(std::string_view text);
+	TextBuf(TextBuf&& rhs) noexcept;
+	TextBuf& operator=(TextBuf&& rhs) noexcept;
+	~TextBuf() noexcept;
+
+	std::string_view view() const;
+	operator std::string_view() const { return view(); }
+	bool is_mapped() const { return m_mapped != nullptr; }
+	explicit operator bool() const { return m_valid; }
+
+  private:
+	void release() noexcept;
+
+	CharBuf m_owned{};
+	void* m_mapped{};
+	std::size_t m_size{}; // mapped size
+	bool m_valid{};
+};
+} // namespace toylang::util
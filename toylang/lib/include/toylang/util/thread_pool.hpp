@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace toylang::util {
+///
+/// \brief Fixed set of workers, each with its own task queue: idle workers steal from the back of others' queues
+///
+class ThreadPool {
+  public:
+	using Task = std::function<void()>;
+
+	explicit ThreadPool(std::size_t threads) {
+		if (threads == 0) { threads = 1; }
+		for (std::size_t i = 0; i < threads; ++i) { m_queues.push_back(std::make_unique<Queue>()); }
+		for (std::size_t i = 0; i < threads; ++i) {
+			m_threads.emplace_back([this, i] { work(i); });
+		}
+	}
+
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	~ThreadPool() {
+		wait();
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			m_stop = true;
+		}
+		m_work.notify_all();
+		for (auto& thread : m_threads) { thread.join(); }
+	}
+
+	std::size_t size() const { return m_threads.size(); }
+
+	///
+	/// \brief Queue task: on the calling worker's own queue when called from one of this pool's tasks
+	/// (spawned work stays local while idle workers steal it), otherwise round robin
+	///
+	void push(Task task) {
+		auto& queue = *m_queues[home()];
+		{
+			auto lock = std::scoped_lock{queue.mutex};
+			queue.tasks.push_back(std::move(task));
+		}
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			++m_queued;
+			++m_pending;
+		}
+		m_work.notify_one();
+	}
+
+	///
+	/// \brief Block until every pushed task has completed
+	///
+	void wait() {
+		auto lock = std::unique_lock{m_mutex};
+		m_idle.wait(lock, [this] { return m_pending == 0; });
+	}
+
+	///
+	/// \brief Run one queued task on the calling thread, if any (lets blocked callers help instead of idling)
+	///
+	bool try_run() {
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			if (m_queued == 0) { return false; }
+			--m_queued;
+		}
+		execute(home());
+		return true;
+	}
+
+  private:
+	struct Queue {
+		std::mutex mutex{};
+		std::deque<Task> tasks{};
+	};
+
+	struct Worker {
+		ThreadPool const* pool{};
+		std::size_t index{};
+	};
+
+	static Worker& this_worker() {
+		thread_local auto ret = Worker{};
+		return ret;
+	}
+
+	std::size_t home() {
+		if (auto const& worker = this_worker(); worker.pool == this) { return worker.index; }
+		return m_next++ % m_queues.size();
+	}
+
+	bool pop(std::size_t self, Task& out) {
+		for (std::size_t i = 0; i < m_queues.size(); ++i) {
+			auto& queue = *m_queues[(self + i) % m_queues.size()];
+			auto lock = std::scoped_lock{queue.mutex};
+			if (queue.tasks.empty()) { continue; }
+			// own queue: FIFO from the front; others: steal from the back
+			if (i == 0) {
+				out = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			} else {
+				out = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void work(std::size_t self) {
+		this_worker() = {this, self};
+		while (true) {
+			{
+				auto lock = std::unique_lock{m_mutex};
+				m_work.wait(lock, [this] { return m_stop || m_queued > 0; });
+				if (m_queued == 0) { return; }
+				--m_queued;
+			}
+			execute(self);
+		}
+	}
+
+	void execute(std::size_t self) {
+		// a task is reserved for this thread: keep looking until it is found in some queue
+		auto task = Task{};
+		while (!pop(self, task)) { std::this_thread::yield(); }
+		task();
+		auto lock = std::scoped_lock{m_mutex};
+		if (--m_pending == 0) { m_idle.notify_all(); }
+	}
+
+	std::vector<std::unique_ptr<Queue>> m_queues{};
+	std::vector<std::thread> m_threads{};
+	std::mutex m_mutex{};
+	std::condition_variable m_work{};
+	std::condition_variable m_idle{};
+	std::atomic<std::size_t> m_next{};
+	std::size_t m_queued{};
+	std::size_t m_pending{};
+	bool m_stop{};
+};
+} // namespace toylang::util
@@ -5,7 +5,9 @@
 #include <memory>
 #include <span>
 #include <string>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace toylang {
 class Literal;
@@ -43,7 +45,7 @@ struct StructDef {
 /// \brief Struct instance
 ///
 struct StructInst {
-	using Fields = std::unordered_map<std::string_view, Value>;
+	struct Fields;
 
 	StructDef def{};
 
@@ -52,14 +54,78 @@ struct StructInst {
 	bool set(std::string_view name, Value&& value);
 };
 
+///
+/// \brief Substring of a shared immutable buffer: a string value that doesn't own (or copy) its characters
+///
+struct StrSlice {
+	std::shared_ptr<std::string const> buffer{};
+	std::size_t offset{};
+	std::size_t length{};
+
+	std::string_view view() const { return std::string_view{*buffer}.substr(offset, length); }
+};
+
+///
+/// \brief Handle to a function call running on the runtime's scheduler (see Interpreter::spawn)
+///
+struct Task {
+	struct State;
+
+	std::shared_ptr<State> state{};
+};
+
+///
+/// \brief Bounded queue of values shared between tasks / interpreters (see std_channel.tl)
+///
+struct Channel {
+	struct State;
+
+	std::shared_ptr<State> state{};
+};
+
+///
+/// \brief Suspended call of a generator function (one containing yield), advanced by next()
+///
+struct Generator {
+	struct State;
+
+	std::shared_ptr<State> state{};
+
+	bool done() const;
+};
+
+///
+/// \brief Lazy pipeline over a range / List / generator (see std_iter.tl)
+///
+struct Iterator {
+	struct State;
+
+	std::shared_ptr<State> state{};
+};
+
+///
+/// \brief Open file streamed through a fixed size buffer (see std_file.tl)
+///
+struct FileHandle {
+	struct State;
+
+	std::shared_ptr<State> state{};
+};
+
 ///
 /// \brief Value
 ///
 struct Value {
-	using Payload = std::variant<std::nullptr_t, Bool, double, std::string, Invocable, StructDef, StructInst>;
+	using Payload = std::variant<std::nullptr_t, Bool, double, std::string, StrSlice, Invocable, StructDef, StructInst, Task, Channel, Generator, Iterator, FileHandle>;
 	Payload payload{};
 
+	///
+	/// \brief Strings up to small_string_v bytes are copied (no allocation, no refcount), longer ones become slices of buffer
+	///
+	static constexpr std::size_t small_string_v{15};
+
 	static Value make(Literal const& literal);
+	static Value make_slice(std::shared_ptr<std::string const> const& buffer, std::string_view view);
 
 	template <typename T>
 	bool contains() const {
@@ -88,12 +154,39 @@ struct Value {
 
 	bool is_null() const { return contains<std::nullptr_t>(); }
 	bool is_bool() const { return contains<Bool>(); }
+	bool is_string() const { return contains<std::string>() || contains<StrSlice>(); }
+
+	///
+	/// \brief Characters of a std::string or StrSlice payload (empty for other types)
+	///
+	std::string_view as_string() const;
 
 	bool is_truthy() const;
 
 	std::string to_string() const;
 
 	bool operator==(Value const& rhs) const;
+
+	///
+	/// \brief Equal for values of the same type that compare == (std::string and StrSlice count as one type: strings hash their characters).
+	/// == also relates some values of different types (true == 1): those hash differently.
+	///
+	std::size_t hash() const;
+};
+
+///
+/// \brief Field values: destroyed iteratively, so dropping a long chain of instances (eg a List) doesn't recurse once per node
+///
+struct StructInst::Fields : std::unordered_map<std::string_view, Value> {
+	using std::unordered_map<std::string_view, Value>::unordered_map;
+
+	Fields() = default;
+	Fields(Fields const&) = default;
+	Fields& operator=(Fields const&) = default;
+	~Fields();
+
+	// storage of keys / the struct name built at runtime (JSON, deserialize), when they aren't views into source text
+	std::shared_ptr<void const> names{};
 };
 
 template <typename... T>
@@ -105,4 +198,16 @@ template <typename... T>
 Overloaded(T...) -> Overloaded<T...>;
 
 std::string to_string(Value const& value);
+void append_to(std::string& out, Value const& value);
+
+///
+/// \brief Copy a slice into its own string if it would otherwise keep a buffer much larger than itself alive
+///
+void compact(Value& value);
+
+///
+/// \brief Deep copy struct instances reachable from values (sharing between them is preserved), compacting string slices.
+/// Generators, iterators and files belong to the task that made them: reachable handles are invalidated (false if there were any).
+///
+bool detach(std::vector<Value*> values);
 } // namespace toylang
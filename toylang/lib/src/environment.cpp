@@ -1,9 +1,41 @@
 #include <toylang/environment.hpp>
+#include <cassert>
 #include <utility>
 
 namespace toylang {
 Environment::Environment() { m_book.push_back(make_chapter()); }
 
+std::size_t Environment::size() const {
+	auto ret = std::size_t{};
+	for (auto const& chapter : m_book) {
+		for (auto const& page : chapter) { ret += page.size(); }
+	}
+	return ret;
+}
+
+Environment Environment::clone() const {
+	auto ret = Environment{*this};
+	auto values = std::vector<Value*>{};
+	for (auto& chapter : ret.m_book) {
+		for (auto& page : chapter) {
+			for (auto& [_, value] : page) { values.push_back(&value); }
+		}
+	}
+	// the copy may go to another task: it gets invalid handles rather than shared ones
+	detach(std::move(values));
+	return ret;
+}
+
+Environment Environment::clone_globals() const {
+	assert(!m_book.empty() && !m_book.front().empty());
+	auto ret = Environment{};
+	ret.m_book.front().front() = m_book.front().front();
+	auto values = std::vector<Value*>{};
+	for (auto& [_, value] : ret.global()) { values.push_back(&value); }
+	detach(std::move(values));
+	return ret;
+}
+
 bool Environment::assign(std::string_view const& key, Value value) {
 	if (auto* target = find(key)) {
 		*target = std::move(value);
@@ -40,6 +72,14 @@ void Environment::end_scope() {
 	m_book.back().pop_back();
 }
 
+void Environment::suspend(Suspended& out) {
+	assert(m_book.size() > 1);
+	out.m_chapter = std::move(m_book.back());
+	m_book.pop_back();
+}
+
+void Environment::resume(Suspended& frame) { m_book.push_back(std::move(frame.m_chapter)); }
+
 void Environment::push_frame() { m_book.push_back(make_chapter()); }
 
 void Environment::pop_frame() {
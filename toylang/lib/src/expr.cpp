@@ -3,6 +3,10 @@
 #include <toylang/util/expr_str.hpp>
 
 namespace toylang {
+ExprLiteral::ExprLiteral(Literal value, Token self) : value{std::move(value)}, self(std::move(self)) {
+	if (this->value.type() == Literal::Type::eString) { text = std::make_shared<std::string const>(util::unescape(this->value.as_string())); }
+}
+
 Value ExprLiteral::accept(Visitor& out) const { return out.visit(*this); }
 Value ExprGroup::accept(Visitor& out) const { return out.visit(*this); }
 Value ExprUnary::accept(Visitor& out) const { return out.visit(*this); }
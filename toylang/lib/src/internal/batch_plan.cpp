@@ -0,0 +1,347 @@
+#include <internal/batch_plan.hpp>
+#include <algorithm>
+#include <functional>
+
+namespace toylang::batch {
+namespace {
+///
+/// \brief Rows evaluating the right hand side of and / or: below this fraction they're gathered (selection vector), otherwise all rows run
+///
+constexpr std::size_t sparse_div_v{4};
+
+// restrict: lets the compiler vectorize the loops (outputs never alias inputs)
+template <typename R, typename A, typename F>
+void unary(R* __restrict out, A const* a, std::size_t const n, F const f) {
+	for (std::size_t i = 0; i < n; ++i) { out[i] = f(a[i]); }
+}
+
+template <typename R, typename A, typename B, typename F>
+void binary(R* __restrict out, A const* a, B const* b, std::size_t const n, F const f) {
+	for (std::size_t i = 0; i < n; ++i) { out[i] = f(a[i], b[i]); }
+}
+
+template <typename T>
+T const* gather(T* __restrict out, T const* column, std::uint32_t const* index, std::size_t const n) {
+	for (std::size_t i = 0; i < n; ++i) { out[i] = column[index[i]]; }
+	return out;
+}
+
+template <typename Cmp>
+struct Compare {
+	template <typename T>
+	std::uint8_t operator()(T const& a, T const& b) const {
+		return Cmp{}(a, b) ? 1 : 0;
+	}
+};
+} // namespace
+
+struct Plan::Builder {
+	Plan& plan;
+	std::span<std::string_view const> names;
+	std::span<Column const> columns;
+	Environment& globals;
+	std::deque<std::string>& storage;
+
+	static constexpr Type column_types_v[] = {Type::eNumber, Type::eBool, Type::eString};
+
+	std::uint32_t add(Node node) {
+		plan.m_nodes.push_back(node);
+		return static_cast<std::uint32_t>(plan.m_nodes.size() - 1);
+	}
+
+	std::uint32_t constant(bool const value) { return add({.op = Op::eConst, .type = Type::eBool, .boolean = std::uint8_t{value}}); }
+
+	Type type(std::uint32_t const id) const { return plan.m_nodes[id].type; }
+
+	bool build(Expr const* expr, std::uint32_t& out) {
+		if (auto const* group = dynamic_cast<ExprGroup const*>(expr)) { return group->expr && build(group->expr.get(), out); }
+		if (auto const* literal = dynamic_cast<ExprLiteral const*>(expr)) { return build(*literal, out); }
+		if (auto const* var = dynamic_cast<ExprVar const*>(expr)) { return build(*var, out); }
+		if (auto const* unary = dynamic_cast<ExprUnary const*>(expr)) { return build(*unary, out); }
+		if (auto const* binary = dynamic_cast<ExprBinary const*>(expr)) { return build(*binary, out); }
+		if (auto const* logical = dynamic_cast<ExprLogical const*>(expr)) { return build(*logical, out); }
+		return false;
+	}
+
+	bool build(ExprLiteral const& literal, std::uint32_t& out) {
+		// string literals live as long as the expression
+		if (literal.text) {
+			out = add({.op = Op::eConst, .type = Type::eString, .string = *literal.text});
+			return true;
+		}
+		return build(Value::make(literal.value), out);
+	}
+
+	bool build(Value const& value, std::uint32_t& out) {
+		auto const visitor = Overloaded{
+			[&](double const d) {
+				out = add({.op = Op::eConst, .type = Type::eNumber, .number = d});
+				return true;
+			},
+			[&](Bool const b) {
+				out = constant(b.value);
+				return true;
+			},
+			[&](std::string const& str) {
+				out = add({.op = Op::eConst, .type = Type::eString, .string = storage.emplace_back(str)});
+				return true;
+			},
+			[&](StrSlice const& str) {
+				out = add({.op = Op::eConst, .type = Type::eString, .string = storage.emplace_back(str.view())});
+				return true;
+			},
+			[](auto const&) { return false; },
+		};
+		return value.visit(visitor);
+	}
+
+	bool build(ExprVar const& var, std::uint32_t& out) {
+		if (auto const it = std::ranges::find(names, var.name.lexeme); it != names.end()) {
+			auto const column = static_cast<std::uint32_t>(it - names.begin());
+			out = add({.op = Op::eColumn, .type = column_types_v[columns[column].index()], .lhs = column});
+			return true;
+		}
+		auto const* global = globals.find(var.name.lexeme);
+		return global && build(*global, out);
+	}
+
+	bool build(ExprUnary const& unary, std::uint32_t& out) {
+		auto rhs = std::uint32_t{};
+		if (!unary.rhs || !build(unary.rhs.get(), rhs)) { return false; }
+		switch (unary.op.type) {
+		case TokenType::eMinus: {
+			if (type(rhs) != Type::eNumber) { return false; }
+			out = add({.op = Op::eNeg, .type = Type::eNumber, .rhs = rhs});
+			return true;
+		}
+		case TokenType::eBang: {
+			// numbers and strings are always truthy
+			out = type(rhs) == Type::eBool ? add({.op = Op::eNot, .type = Type::eBool, .rhs = rhs}) : constant(false);
+			return true;
+		}
+		default: return false;
+		}
+	}
+
+	bool build(ExprBinary const& binary, std::uint32_t& out) {
+		auto lhs = std::uint32_t{};
+		auto rhs = std::uint32_t{};
+		if (!binary.lhs || !binary.rhs || !build(binary.lhs.get(), lhs) || !build(binary.rhs.get(), rhs)) { return false; }
+		auto const arithmetic = [&](Op const op) {
+			// strings: + concatenates (allocates: left to the interpreter)
+			if (type(lhs) != Type::eNumber || type(rhs) != Type::eNumber) { return false; }
+			out = add({.op = op, .type = Type::eNumber, .lhs = lhs, .rhs = rhs});
+			return true;
+		};
+		auto const comparison = [&](Op const op) {
+			if (type(lhs) != type(rhs) || type(lhs) == Type::eBool) { return false; }
+			out = add({.op = op, .type = Type::eBool, .operand = type(lhs), .lhs = lhs, .rhs = rhs});
+			return true;
+		};
+		auto const equality = [&](bool const equal) {
+			if (type(lhs) == type(rhs)) {
+				out = add({.op = equal ? Op::eEq : Op::eNe, .type = Type::eBool, .operand = type(lhs), .lhs = lhs, .rhs = rhs});
+				return true;
+			}
+			// like Value::operator==: a number equals a bool by its truthiness (always true), strings equal nothing else
+			if (type(lhs) != Type::eString && type(rhs) != Type::eString) {
+				auto const boolean = type(lhs) == Type::eBool ? lhs : rhs;
+				out = equal ? boolean : add({.op = Op::eNot, .type = Type::eBool, .rhs = boolean});
+				return true;
+			}
+			out = constant(!equal);
+			return true;
+		};
+		switch (binary.op.type) {
+		case TokenType::ePlus: return arithmetic(Op::eAdd);
+		case TokenType::eMinus: return arithmetic(Op::eSub);
+		case TokenType::eStar: return arithmetic(Op::eMul);
+		case TokenType::eSlash: return arithmetic(Op::eDiv);
+		case TokenType::eEqEq: return equality(true);
+		case TokenType::eBangEq: return equality(false);
+		case TokenType::eLt: return comparison(Op::eLt);
+		case TokenType::eLe: return comparison(Op::eLe);
+		case TokenType::eGt: return comparison(Op::eGt);
+		case TokenType::eGe: return comparison(Op::eGe);
+		default: return false;
+		}
+	}
+
+	bool build(ExprLogical const& logical, std::uint32_t& out) {
+		auto lhs = std::uint32_t{};
+		auto rhs = std::uint32_t{};
+		if (!logical.lhs || !logical.rhs || !build(logical.lhs.get(), lhs) || !build(logical.rhs.get(), rhs)) { return false; }
+		auto const is_and = logical.op.type == TokenType::eAnd;
+		// a truthy lhs: and yields rhs, or yields lhs
+		if (type(lhs) != Type::eBool) {
+			out = is_and ? rhs : lhs;
+			return true;
+		}
+		// otherwise the result is either side: one column type needs both to be bools
+		if (type(rhs) != Type::eBool) { return false; }
+		out = add({.op = is_and ? Op::eAnd : Op::eOr, .type = Type::eBool, .lhs = lhs, .rhs = rhs});
+		return true;
+	}
+};
+
+bool Plan::make(Expr const& expr, std::span<std::string_view const> names, std::span<Column const> columns, Environment& globals,
+				std::deque<std::string>& storage, Plan& out) {
+	out = {};
+	auto builder = Builder{.plan = out, .names = names, .columns = columns, .globals = globals, .storage = storage};
+	if (!builder.build(&expr, out.m_root)) { return false; }
+	out.m_buffers.resize(out.m_nodes.size());
+	for (std::size_t i = 0; i < out.m_nodes.size(); ++i) {
+		auto const& node = out.m_nodes[i];
+		auto& buffers = out.m_buffers[i];
+		// constants: filled once, then read like a column
+		switch (node.type) {
+		case Type::eNumber: buffers.numbers.assign(chunk_v, node.number); break;
+		case Type::eBool: buffers.bools.assign(chunk_v, node.boolean); break;
+		case Type::eString: buffers.strings.assign(chunk_v, node.string); break;
+		}
+		if (node.op == Op::eAnd || node.op == Op::eOr) {
+			buffers.index.resize(chunk_v);
+			buffers.pos.resize(chunk_v);
+		}
+	}
+	return true;
+}
+
+void Plan::run(std::span<Column const> columns, std::size_t const rows, Output& out) {
+	m_columns = columns;
+	auto const append = [rows](auto& values, auto const* chunk, std::size_t const count) {
+		if (values.empty()) { values.reserve(rows); }
+		values.insert(values.end(), chunk, chunk + count);
+	};
+	auto const reset = [&out]<typename T>(T) {
+		if (auto* values = std::get_if<std::vector<T>>(&out.values)) {
+			values->clear();
+		} else {
+			out.values.emplace<std::vector<T>>();
+		}
+	};
+	switch (m_nodes[m_root].type) {
+	case Type::eNumber: reset(double{}); break;
+	case Type::eBool: reset(std::uint8_t{}); break;
+	case Type::eString: reset(std::string_view{}); break;
+	}
+	for (std::size_t first = 0; first < rows; first += chunk_v) {
+		auto const count = std::min(chunk_v, rows - first);
+		auto const vec = exec(m_root, {.first = first, .count = count});
+		auto const visitor = Overloaded{
+			[&](std::vector<double>& values) { append(values, vec.numbers, count); },
+			[&](std::vector<std::uint8_t>& values) { append(values, vec.bools, count); },
+			[&](std::vector<std::string_view>& values) { append(values, vec.strings, count); },
+		};
+		std::visit(visitor, out.values);
+	}
+}
+
+Plan::Vec Plan::exec(std::uint32_t const id, Rows const rows) {
+	auto const& node = m_nodes[id];
+	auto& buffers = m_buffers[id];
+	auto const n = rows.count;
+	switch (node.op) {
+	case Op::eColumn: {
+		auto const visitor = Overloaded{
+			[&](std::span<double const> column) {
+				auto const* data = column.data() + rows.first;
+				return Vec{.numbers = rows.index ? gather(buffers.numbers.data(), data, rows.index, n) : data};
+			},
+			[&](std::span<std::uint8_t const> column) {
+				auto const* data = column.data() + rows.first;
+				return Vec{.bools = rows.index ? gather(buffers.bools.data(), data, rows.index, n) : data};
+			},
+			[&](std::span<std::string_view const> column) {
+				auto const* data = column.data() + rows.first;
+				return Vec{.strings = rows.index ? gather(buffers.strings.data(), data, rows.index, n) : data};
+			},
+		};
+		return std::visit(visitor, m_columns[node.lhs]);
+	}
+	case Op::eConst: return {.numbers = buffers.numbers.data(), .bools = buffers.bools.data(), .strings = buffers.strings.data()};
+	case Op::eNeg: {
+		unary(buffers.numbers.data(), exec(node.rhs, rows).numbers, n, std::negate<>{});
+		return {.numbers = buffers.numbers.data()};
+	}
+	case Op::eNot: {
+		unary(buffers.bools.data(), exec(node.rhs, rows).bools, n, [](std::uint8_t const b) -> std::uint8_t { return static_cast<std::uint8_t>(b ^ 1); });
+		return {.bools = buffers.bools.data()};
+	}
+	case Op::eAdd:
+	case Op::eSub:
+	case Op::eMul:
+	case Op::eDiv: {
+		auto const* a = exec(node.lhs, rows).numbers;
+		auto const* b = exec(node.rhs, rows).numbers;
+		auto* o = buffers.numbers.data();
+		switch (node.op) {
+		case Op::eAdd: binary(o, a, b, n, std::plus<>{}); break;
+		case Op::eSub: binary(o, a, b, n, std::minus<>{}); break;
+		case Op::eMul: binary(o, a, b, n, std::multiplies<>{}); break;
+		default: binary(o, a, b, n, std::divides<>{}); break;
+		}
+		return {.numbers = o};
+	}
+	case Op::eEq:
+	case Op::eNe:
+	case Op::eLt:
+	case Op::eLe:
+	case Op::eGt:
+	case Op::eGe: {
+		auto const a = exec(node.lhs, rows);
+		auto const b = exec(node.rhs, rows);
+		auto* o = buffers.bools.data();
+		auto const compare = [&](auto const cmp) {
+			switch (node.operand) {
+			case Type::eNumber: binary(o, a.numbers, b.numbers, n, cmp); break;
+			case Type::eBool: binary(o, a.bools, b.bools, n, cmp); break;
+			case Type::eString: binary(o, a.strings, b.strings, n, cmp); break;
+			}
+		};
+		switch (node.op) {
+		case Op::eEq: compare(Compare<std::equal_to<>>{}); break;
+		case Op::eNe: compare(Compare<std::not_equal_to<>>{}); break;
+		case Op::eLt: compare(Compare<std::less<>>{}); break;
+		case Op::eLe: compare(Compare<std::less_equal<>>{}); break;
+		case Op::eGt: compare(Compare<std::greater<>>{}); break;
+		default: compare(Compare<std::greater_equal<>>{}); break;
+		}
+		return {.bools = o};
+	}
+	case Op::eAnd:
+	case Op::eOr: {
+		auto const* a = exec(node.lhs, rows).bools;
+		// rows whose result is the rhs: true for and, false for or
+		auto const want = static_cast<std::uint8_t>(node.op == Op::eAnd ? 1 : 0);
+		auto* index = buffers.index.data();
+		auto* pos = buffers.pos.data();
+		auto k = std::size_t{};
+		for (std::size_t i = 0; i < n; ++i) {
+			// branch free: always write, only advance on a match
+			index[k] = rows.index ? rows.index[i] : static_cast<std::uint32_t>(i);
+			pos[k] = static_cast<std::uint32_t>(i);
+			k += a[i] == want ? 1 : 0;
+		}
+		if (k == 0) { return {.bools = a}; }
+		if (k == n) { return exec(node.rhs, rows); }
+		auto* o = buffers.bools.data();
+		if (k * sparse_div_v > n) {
+			// most rows need the rhs: evaluating all of them densely is cheaper than gathering (operands are pure, so it's unobservable)
+			auto const* b = exec(node.rhs, rows).bools;
+			if (want) {
+				binary(o, a, b, n, std::bit_and<std::uint8_t>{});
+			} else {
+				binary(o, a, b, n, std::bit_or<std::uint8_t>{});
+			}
+			return {.bools = o};
+		}
+		auto const* b = exec(node.rhs, {.first = rows.first, .count = k, .index = index}).bools;
+		std::copy(a, a + n, o);
+		for (std::size_t j = 0; j < k; ++j) { o[pos[j]] = b[j]; }
+		return {.bools = o};
+	}
+	}
+	return {};
+}
+} // namespace toylang::batch
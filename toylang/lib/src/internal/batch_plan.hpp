@@ -0,0 +1,86 @@
+#pragma once
+#include <toylang/batch.hpp>
+#include <toylang/environment.hpp>
+#include <toylang/expr.hpp>
+#include <deque>
+
+namespace toylang::batch {
+///
+/// \brief Rows are evaluated this many at a time: every node's intermediate values stay in cache
+///
+inline constexpr std::size_t chunk_v{1024};
+
+///
+/// \brief Expression tree type checked against its columns, run a chunk at a time by per-node kernels.
+/// The right hand side of and / or only runs on the rows that need it (a selection vector), unless most of them do.
+///
+class Plan {
+  public:
+	///
+	/// \brief False if expr needs the interpreter: calls, fields, string concatenation, operands that would be a runtime error, ...
+	/// Names not bound to a column are read from globals once (numbers, bools and strings only): strings are copied into storage,
+	/// which must outlive the plan's results (a deque: the copies never move).
+	///
+	static bool make(Expr const& expr, std::span<std::string_view const> names, std::span<Column const> columns, Environment& globals,
+					 std::deque<std::string>& storage, Plan& out);
+
+	void run(std::span<Column const> columns, std::size_t rows, Output& out);
+
+  private:
+	enum class Type : std::uint8_t { eNumber, eBool, eString };
+	enum class Op : std::uint8_t { eColumn, eConst, eNeg, eNot, eAdd, eSub, eMul, eDiv, eEq, eNe, eLt, eLe, eGt, eGe, eAnd, eOr };
+
+	struct Node {
+		Op op{};
+		Type type{};
+		// operand types of comparisons
+		Type operand{};
+		// children (eColumn: the column)
+		std::uint32_t lhs{};
+		std::uint32_t rhs{};
+		// eConst
+		double number{};
+		std::uint8_t boolean{};
+		std::string_view string{};
+	};
+
+	///
+	/// \brief Per node output (and and / or selection vectors), chunk_v entries each: allocated once, reused by every chunk
+	///
+	struct Buffers {
+		std::vector<double> numbers{};
+		std::vector<std::uint8_t> bools{};
+		std::vector<std::string_view> strings{};
+		// rows (within the chunk) that evaluate the right hand side, and their positions in this node's output
+		std::vector<std::uint32_t> index{};
+		std::vector<std::uint32_t> pos{};
+	};
+
+	///
+	/// \brief Values of a node for the selected rows, densely: one of the pointers is set (by the node's type)
+	///
+	struct Vec {
+		double const* numbers{};
+		std::uint8_t const* bools{};
+		std::string_view const* strings{};
+	};
+
+	///
+	/// \brief Rows [first, first + count) of the columns, or (if index is set) first + index[i] for i in [0, count)
+	///
+	struct Rows {
+		std::size_t first{};
+		std::size_t count{};
+		std::uint32_t const* index{};
+	};
+
+	struct Builder;
+
+	Vec exec(std::uint32_t id, Rows rows);
+
+	std::vector<Node> m_nodes{};
+	std::vector<Buffers> m_buffers{};
+	std::span<Column const> m_columns{};
+	std::uint32_t m_root{};
+};
+} // namespace toylang::batch
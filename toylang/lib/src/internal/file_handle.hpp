@@ -0,0 +1,9 @@
+#pragma once
+#include <toylang/util/file_reader.hpp>
+#include <toylang/value.hpp>
+
+namespace toylang {
+struct FileHandle::State {
+	util::FileReader reader{};
+};
+} // namespace toylang
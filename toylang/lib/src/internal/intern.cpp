@@ -0,0 +1,9 @@
+#include <internal/intern.hpp>
+
+namespace toylang {
+std::string_view Names::intern(std::string_view const name) {
+	auto it = m_names.find(name);
+	if (it == m_names.end()) { it = m_names.emplace(name).first; }
+	return *it;
+}
+} // namespace toylang
@@ -0,0 +1,25 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace toylang {
+///
+/// \brief Stable copies of struct names / field keys built at runtime (StructDef / StructInst hold views, which must outlive every instance).
+/// One per JSON parse / deserialization: each instance it builds keeps it alive (StructInst::Fields::names), so keys are freed with their data.
+///
+class Names {
+  public:
+	std::string_view intern(std::string_view name);
+
+  private:
+	struct Hash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view const str) const { return std::hash<std::string_view>{}(str); }
+	};
+
+	// nodes never move: views stay valid as the set grows
+	std::unordered_set<std::string, Hash, std::equal_to<>> m_names{};
+};
+} // namespace toylang
@@ -1,9 +1,35 @@
+#include <internal/file_handle.hpp>
 #include <internal/intrinsics.hpp>
+#include <internal/iterators.hpp>
+#include <internal/json.hpp>
+#include <internal/memo.hpp>
+#include <internal/scheduler.hpp>
+#include <internal/serial.hpp>
+#include <internal/sort.hpp>
 #include <toylang/interpreter.hpp>
 #include <toylang/util.hpp>
+#include <toylang/util/file_reader.hpp>
+#include <toylang/util/mpmc_queue.hpp>
+#include <toylang/util/str_search.hpp>
+#include <toylang/util/text_buf.hpp>
 #include <toylang/value.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <chrono>
 #include <filesystem>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace toylang {
+struct Channel::State {
+	explicit State(std::size_t capacity) : queue(capacity) {}
+
+	util::MpmcQueue<Value> queue;
+	std::atomic<bool> closed{};
+};
+} // namespace toylang
 
 namespace toylang::intrinsics {
 namespace fs = std::filesystem;
@@ -23,47 +49,204 @@ template <typename T>
 double to_double(T const& tp) {
 	return std::chrono::duration<double>(tp.time_since_epoch()).count();
 }
+
+Channel::State* get_channel(Interpreter& in, CallContext const& ctx, std::string_view name) {
+	auto const* channel = ctx.args.empty() ? nullptr : std::get_if<Channel>(&ctx.args.front().payload);
+	if (!channel || !channel->state) {
+		auto msg = std::string{name};
+		util::append(msg, ": Requires a channel");
+		in.runtime_error(ctx.callee, msg);
+		return {};
+	}
+	return channel->state.get();
+}
+
+util::FileReader* get_file(Interpreter& in, CallContext const& ctx, std::string_view name) {
+	auto const* file = ctx.args.empty() ? nullptr : std::get_if<FileHandle>(&ctx.args.front().payload);
+	if (!file || !file->state) {
+		auto msg = std::string{name};
+		util::append(msg, ": Requires a file");
+		in.runtime_error(ctx.callee, msg);
+		return {};
+	}
+	return &file->state->reader;
+}
+
+bool check_strings(Interpreter& in, CallContext const& ctx, std::string_view name, std::size_t count) {
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!ctx.args[i].is_string()) {
+			auto msg = std::string{name};
+			util::append(msg, ": Requires string arguments");
+			in.runtime_error(ctx.callee, msg);
+			return false;
+		}
+	}
+	return true;
+}
+
+Value index_value(std::size_t const index) { return {.payload = index == util::npos_v ? -1.0 : static_cast<double>(index)}; }
+
+///
+/// \brief String argument as a slice: an owned string (the call's own copy) moves into a shared buffer instead of being copied again
+///
+StrSlice to_slice(Value& arg) {
+	if (auto const* slice = std::get_if<StrSlice>(&arg.payload)) { return *slice; }
+	auto& str = arg.get<std::string>();
+	auto const length = str.size();
+	return {.buffer = std::make_shared<std::string const>(std::move(str)), .length = length};
+}
+
+Value sub_slice(Value& arg, std::size_t const offset, std::size_t const count) {
+	auto const owned = arg.contains<std::string>();
+	auto const whole = to_slice(arg);
+	auto ret = Value::make_slice(whole.buffer, whole.view().substr(offset, count));
+	// a short part of an owned string doesn't keep all of it alive
+	if (owned) { compact(ret); }
+	return ret;
+}
+
+///
+/// \brief Encode into a buffer reused by every call on this thread (no reallocation once it has grown to fit)
+///
+std::string* encode(Interpreter& in, CallContext const& ctx, std::string_view name) {
+	thread_local auto buffer = std::string{};
+	buffer.clear();
+	if (!serial::encode(ctx.args.front(), buffer)) {
+		auto msg = std::string{name};
+		util::append(msg, ": Value can't be serialized");
+		in.runtime_error(ctx.callee, msg);
+		return {};
+	}
+	return &buffer;
+}
+
+Iterator::State* get_iterable(Interpreter& in, CallContext const& ctx, std::string_view name, std::shared_ptr<Iterator::State>& out) {
+	out = ctx.args.empty() ? nullptr : Iterator::State::make(ctx.args.front());
+	if (!out) {
+		auto msg = std::string{name};
+		util::append(msg, ": Requires an iterator, generator, file or list");
+		in.runtime_error(ctx.callee, msg);
+	}
+	return out.get();
+}
+
+bool check_invocable(Interpreter& in, CallContext const& ctx, std::string_view name, Value const& fn) {
+	if (auto const* inv = std::get_if<Invocable>(&fn.payload); inv && inv->callback) { return true; }
+	auto msg = std::string{name};
+	util::append(msg, ": Requires a function");
+	in.runtime_error(ctx.callee, msg);
+	return false;
+}
+
+Value make_stage(Interpreter& in, CallContext const& ctx, std::string_view name, Iterator::State::Op op) {
+	auto source = std::shared_ptr<Iterator::State>{};
+	if (!check_arg_count(in, ctx, name, 2) || !get_iterable(in, ctx, name, source) || !check_invocable(in, ctx, name, ctx.args[1])) { return {}; }
+	return {.payload = source->then(op, ctx.args[1])};
+}
+
+///
+/// \brief Spin briefly, then run queued tasks (the peer may be one of them), then sleep: until ready() or the deadline passes
+///
+template <typename Pred>
+bool block_until(Interpreter& in, CallContext const& ctx, Pred ready) {
+	static constexpr std::uint32_t spins_v{64};
+	for (std::uint32_t i = 0; !ready(); ++i) {
+		if (i < spins_v) {
+			std::this_thread::yield();
+			continue;
+		}
+		if (Interpreter::Clock::now() >= in.deadline) {
+			in.runtime_error(ctx.callee, "Timed out");
+			return false;
+		}
+		if (!scheduler::pool().try_run()) { std::this_thread::sleep_for(std::chrono::microseconds{50}); }
+	}
+	return true;
+}
 } // namespace
 
-Value Print::operator()(Interpreter&, CallContext ctx) const {
+Value Print::operator()(Interpreter& in, CallContext ctx) const {
 	auto str = util::concat(ctx.args);
 	util::append(str, "\n");
-	util::print(str.c_str());
+	in.write(str);
 	return {.payload = static_cast<double>(ctx.args.size())};
 }
 
+///
+/// \brief Format strings parsed once into literal runs: a {} placeholder sits between each pair of texts
+///
+struct PrintF::Cache {
+	struct Format {
+		std::vector<std::string> texts{};
+		bool terminated{true};
+	};
+
+	// lookup by string_view: fmt may be a slice
+	struct Hash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view const str) const { return std::hash<std::string_view>{}(str); }
+	};
+
+	static constexpr std::size_t max_entries_v{256};
+
+	std::unordered_map<std::string, Format, Hash, std::equal_to<>> formats{};
+	std::string buffer{};
+
+	static Format compile(std::string_view fmt) {
+		auto ret = Format{};
+		while (true) {
+			auto const lbrace = fmt.find('{');
+			if (lbrace == std::string_view::npos) {
+				ret.texts.emplace_back(fmt);
+				break;
+			}
+			auto const rbrace = fmt.find('}', lbrace);
+			if (rbrace == std::string_view::npos) {
+				ret.terminated = false;
+				break;
+			}
+			ret.texts.emplace_back(fmt.substr(0, lbrace));
+			fmt = fmt.substr(rbrace + 1);
+		}
+		return ret;
+	}
+
+	Format const& get(std::string_view const fmt) {
+		if (auto it = formats.find(fmt); it != formats.end()) { return it->second; }
+		if (formats.size() >= max_entries_v) { formats.clear(); }
+		return formats.emplace(fmt, compile(fmt)).first->second;
+	}
+};
+
 Value PrintF::operator()(Interpreter& in, CallContext ctx) const {
 	if (ctx.args.empty()) { return {.payload = 0.0}; }
-	if (!ctx.args[0].contains<std::string>()) {
+	if (!ctx.args[0].is_string()) {
 		in.runtime_error(ctx.callee, "printf: Invalid fmt");
 		return {.payload = -1.0};
 	}
-	auto str = std::string{};
+	// per thread: Interpreters sharing a Program / Image may run concurrently
+	thread_local auto cache = Cache{};
+	auto const& fmt = cache.get(ctx.args[0].as_string());
+	if (!fmt.terminated) {
+		in.runtime_error(ctx.callee, "printf: Unterminated '{'");
+		return {.payload = -1.0};
+	}
+	auto& str = cache.buffer;
+	str.clear();
 	auto ret = std::size_t{};
-	std::string_view fmt = ctx.args[0].get<std::string>();
 	ctx.args = ctx.args.subspan(1);
-	while (!fmt.empty()) {
-		if (auto const lbrace = fmt.find('{'); lbrace != std::string_view::npos) {
-			auto const rbrace = fmt.find('}', lbrace);
-			if (rbrace == std::string_view::npos) {
-				in.runtime_error(ctx.callee, "printf: Unterminated '{'");
-				return {.payload = -1.0};
-			}
-			util::append(str, fmt.substr(0, lbrace));
-			if (!ctx.args.empty()) {
-				util::append(str, to_string(ctx.args.front()));
-				ctx.args = ctx.args.subspan(1);
-				++ret;
+	for (std::size_t i = 0; i < fmt.texts.size(); ++i) {
+		if (i > 0) {
+			if (ret < ctx.args.size()) {
+				auto const& arg = ctx.args[ret++];
+				append_to(str, arg);
 			} else {
 				util::append(str, "{}");
 			}
-			fmt = fmt.substr(rbrace + 1);
-		} else {
-			util::append(str, fmt);
-			fmt = {};
 		}
+		util::append(str, fmt.texts[i]);
 	}
-	std::printf("%s", util::unescape(str).c_str());
+	in.write(str);
 	return {.payload = static_cast<double>(ret)};
 }
 
@@ -87,6 +270,105 @@ Value Str::operator()(Interpreter& in, CallContext ctx) const {
 	return Value{.payload = to_string(ctx.args.front())};
 }
 
+Value Num::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto const& arg = ctx.args.front();
+	if (arg.contains<double>()) { return arg; }
+	if (!arg.is_string()) { return {}; }
+	auto const str = arg.as_string();
+	auto ret = double{};
+	auto const last = str.data() + str.size();
+	if (auto const [ptr, ec] = std::from_chars(str.data(), last, ret); ec != std::errc{} || ptr != last) { return {}; }
+	return Value{.payload = ret};
+}
+
+Value Len::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	if (!ctx.args.front().is_string()) {
+		in.runtime_error(ctx.callee, "_len: Requires a string");
+		return {};
+	}
+	return {.payload = static_cast<double>(ctx.args.front().as_string().size())};
+}
+
+Value Substr::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 3)) { return {}; }
+	auto& arg = ctx.args[0];
+	auto const* start = std::get_if<double>(&ctx.args[1].payload);
+	auto const* length = std::get_if<double>(&ctx.args[2].payload);
+	if (!arg.is_string() || !start || !length || *start < 0.0 || *length < 0.0) {
+		in.runtime_error(ctx.callee, "_substr: Requires (string, start, length) arguments");
+		return {};
+	}
+	auto const str = arg.as_string();
+	auto const offset = std::min(static_cast<std::size_t>(*start), str.size());
+	auto const count = std::min(static_cast<std::size_t>(*length), str.size() - offset);
+	if (count <= Value::small_string_v) { return {.payload = std::string{str.substr(offset, count)}}; }
+	return sub_slice(arg, offset, count);
+}
+
+Value Find::operator()(Interpreter& in, CallContext ctx) const {
+	if (ctx.args.size() != 2 && ctx.args.size() != 3) {
+		in.runtime_error(ctx.callee, "_find: Requires (string, string[, from]) arguments");
+		return {};
+	}
+	if (!check_strings(in, ctx, name_v, 2)) { return {}; }
+	auto from = std::size_t{};
+	if (ctx.args.size() == 3) {
+		auto const* arg = std::get_if<double>(&ctx.args[2].payload);
+		if (!arg || *arg < 0.0) {
+			in.runtime_error(ctx.callee, "_find: Invalid from");
+			return {};
+		}
+		from = static_cast<std::size_t>(*arg);
+	}
+	return index_value(util::find(ctx.args[0].as_string(), ctx.args[1].as_string(), from));
+}
+
+Value RFind::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2) || !check_strings(in, ctx, name_v, 2)) { return {}; }
+	return index_value(util::rfind(ctx.args[0].as_string(), ctx.args[1].as_string()));
+}
+
+Value Count::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2) || !check_strings(in, ctx, name_v, 2)) { return {}; }
+	return {.payload = static_cast<double>(util::count(ctx.args[0].as_string(), ctx.args[1].as_string()))};
+}
+
+Value StartsWith::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2) || !check_strings(in, ctx, name_v, 2)) { return {}; }
+	return {.payload = Bool{ctx.args[0].as_string().starts_with(ctx.args[1].as_string())}};
+}
+
+Value Replace::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 3) || !check_strings(in, ctx, name_v, 3)) { return {}; }
+	auto const str = ctx.args[0].as_string();
+	auto const from = ctx.args[1].as_string();
+	// nothing to replace: the argument is returned as is (a slice stays a slice)
+	if (from.empty() || util::find(str, from) == util::npos_v) { return std::move(ctx.args[0]); }
+	return {.payload = util::replace(str, from, ctx.args[2].as_string())};
+}
+
+Value Split::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2) || !check_strings(in, ctx, name_v, 2)) { return {}; }
+	auto delim = std::string{ctx.args[1].as_string()};
+	if (delim.empty()) {
+		in.runtime_error(ctx.callee, "_split: Empty delimiter");
+		return {};
+	}
+	auto split = Iterator::State::Split{.text = to_slice(ctx.args[0]), .delim = std::move(delim)};
+	return {.payload = Iterator{std::make_shared<Iterator::State>(Iterator::State{.source = std::move(split)})}};
+}
+
+Value Trim::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1) || !check_strings(in, ctx, name_v, 1)) { return {}; }
+	auto const str = ctx.args[0].as_string();
+	auto const trimmed = util::trim(str);
+	if (trimmed.size() == str.size()) { return std::move(ctx.args[0]); }
+	if (trimmed.size() <= Value::small_string_v) { return {.payload = std::string{trimmed}}; }
+	return sub_slice(ctx.args[0], static_cast<std::size_t>(trimmed.data() - str.data()), trimmed.size());
+}
+
 Value Now::operator()(Interpreter& in, CallContext ctx) const {
 	if (!check_arg_count(in, ctx, name_v, 0)) { return {}; }
 	return Value{.payload = to_double(std::chrono::steady_clock::now())};
@@ -97,27 +379,413 @@ Value File::operator()(Interpreter& in, CallContext ctx) const {
 		in.runtime_error(ctx.callee, "_file: Requires at least two arguments");
 		return {};
 	}
-	auto* op = std::get_if<std::string>(&ctx.args[0].payload);
-	auto* arg0 = std::get_if<std::string>(&ctx.args[1].payload);
-	if (!op || !arg0) {
+	if (!ctx.args[0].is_string() || !ctx.args[1].is_string()) {
 		in.runtime_error(ctx.callee, "_file: Requires (string, string) arguments");
 		return {};
 	}
-	if (*op == "read") { return Value{.payload = util::read_file(arg0->c_str())}; }
-	if (*op == "write") {
+	auto const op = ctx.args[0].as_string();
+	auto const arg0 = std::string{ctx.args[1].as_string()};
+	if (op == "read") {
+		// shared: copies of the value (and substrings of it) don't copy the file's contents
+		auto const buffer = std::make_shared<std::string const>(util::read_file(arg0.c_str()));
+		return Value::make_slice(buffer, *buffer);
+	}
+	if (op == "write") {
 		if (ctx.args.size() < 3) {
 			in.runtime_error(ctx.callee, "_file.write: Requires (string, string, string) arguments");
 			return {};
 		}
-		auto* arg1 = std::get_if<std::string>(&ctx.args[2].payload);
-		if (!arg1) {
+		if (!ctx.args[2].is_string()) {
 			in.runtime_error(ctx.callee, "_file.write: Invalid path");
 			return {};
 		}
-		return Value{.payload = Bool{util::write_file(arg0->c_str(), *arg1)}};
+		return Value{.payload = Bool{util::write_file(arg0.c_str(), ctx.args[2].as_string())}};
 	}
-	if (*op == "remove") { return Value{.payload = Bool{fs::remove(*arg0)}}; }
+	if (op == "remove") { return Value{.payload = Bool{fs::remove(arg0)}}; }
 	in.runtime_error(ctx.callee, "_file: Invalid operation");
 	return {};
 }
+
+Value Spawn::operator()(Interpreter& in, CallContext ctx) const {
+	if (ctx.args.empty()) {
+		in.runtime_error(ctx.callee, "_spawn: Requires a function");
+		return {};
+	}
+	auto task = in.spawn(ctx.callee, ctx.args.front(), ctx.args.subspan(1));
+	if (!task.state) { return {}; }
+	return Value{.payload = std::move(task)};
+}
+
+Value Join::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto const* task = std::get_if<Task>(&ctx.args.front().payload);
+	if (!task) {
+		in.runtime_error(ctx.callee, "_join: Requires a task");
+		return {};
+	}
+	return in.join(ctx.callee, *task);
+}
+
+Value ForEach::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2)) { return {}; }
+	// walks a std_list.tl List: node.value / node.next
+	auto items = std::vector<Value>{};
+	for (auto const* node = &ctx.args[0]; !node->is_null();) {
+		auto const* inst = std::get_if<StructInst>(&node->payload);
+		auto const* value = inst ? inst->find("value") : nullptr;
+		auto const* next = inst ? inst->find("next") : nullptr;
+		if (!value || !next) {
+			in.runtime_error(ctx.callee, "_for_each: Requires a list");
+			return {};
+		}
+		items.push_back(*value);
+		node = next;
+	}
+	return {.payload = Bool{in.for_each(ctx.callee, ctx.args[1], items)}};
+}
+Value MakeChannel::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto const* capacity = std::get_if<double>(&ctx.args.front().payload);
+	if (!capacity || *capacity < 1.0) {
+		in.runtime_error(ctx.callee, "_channel: Requires a capacity of at least 1");
+		return {};
+	}
+	return {.payload = Channel{std::make_shared<Channel::State>(static_cast<std::size_t>(*capacity))}};
+}
+
+Value Send::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2)) { return {}; }
+	auto* channel = get_channel(in, ctx, name_v);
+	if (!channel) { return {}; }
+	// the argument is this call's own copy: move it into the queue (strings are not copied again), detaching any instances
+	auto value = std::move(ctx.args[1]);
+	if (!detach({&value})) {
+		in.runtime_error(ctx.callee, "_send: Generators, iterators and files cannot be sent");
+		return {};
+	}
+	bool pushed{};
+	auto const ready = [&] {
+		// false: the channel was closed
+		if (channel->closed.load(std::memory_order_acquire)) { return true; }
+		return pushed = channel->queue.try_push(value);
+	};
+	if (!block_until(in, ctx, ready)) { return {}; }
+	return {.payload = Bool{pushed}};
+}
+
+Value Recv::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto* channel = get_channel(in, ctx, name_v);
+	if (!channel) { return {}; }
+	auto ret = Value{};
+	auto const ready = [&] {
+		if (channel->queue.try_pop(ret)) { return true; }
+		if (!channel->closed.load(std::memory_order_acquire)) { return false; }
+		// closed: drain anything sent before the close, then null
+		channel->queue.try_pop(ret);
+		return true;
+	};
+	if (!block_until(in, ctx, ready)) { return {}; }
+	return ret;
+}
+
+Value TryRecv::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto* channel = get_channel(in, ctx, name_v);
+	if (!channel) { return {}; }
+	auto ret = Value{};
+	channel->queue.try_pop(ret);
+	return ret;
+}
+
+Value Close::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	if (auto const* file = std::get_if<FileHandle>(&ctx.args.front().payload); file && file->state) {
+		auto const ret = static_cast<bool>(file->state->reader);
+		file->state->reader.close();
+		return {.payload = Bool{ret}};
+	}
+	auto* channel = get_channel(in, ctx, name_v);
+	if (!channel) { return {}; }
+	return {.payload = Bool{!channel->closed.exchange(true, std::memory_order_acq_rel)}};
+}
+Value Next::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	if (auto const* iterator = std::get_if<Iterator>(&ctx.args.front().payload); iterator && iterator->state) {
+		auto ret = Value{};
+		iterator->state->next(in, ctx.callee, ret);
+		return ret;
+	}
+	auto const* generator = std::get_if<Generator>(&ctx.args.front().payload);
+	if (!generator) {
+		in.runtime_error(ctx.callee, "_next: Requires a generator or iterator");
+		return {};
+	}
+	return in.resume(ctx.callee, *generator);
+}
+
+Value Done::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	if (auto const* iterator = std::get_if<Iterator>(&ctx.args.front().payload); iterator && iterator->state) {
+		return {.payload = Bool{iterator->state->exhausted}};
+	}
+	auto const* generator = std::get_if<Generator>(&ctx.args.front().payload);
+	if (!generator) {
+		in.runtime_error(ctx.callee, "_done: Requires a generator or iterator");
+		return {};
+	}
+	return {.payload = Bool{generator->done()}};
+}
+
+Value Range::operator()(Interpreter& in, CallContext ctx) const {
+	if (ctx.args.size() < 2 || ctx.args.size() > 3) {
+		in.runtime_error(ctx.callee, "_range: Requires (first, last[, step]) arguments");
+		return {};
+	}
+	auto range = Iterator::State::Range{};
+	auto const* first = std::get_if<double>(&ctx.args[0].payload);
+	auto const* last = std::get_if<double>(&ctx.args[1].payload);
+	auto const* step = ctx.args.size() == 3 ? std::get_if<double>(&ctx.args[2].payload) : &range.step;
+	if (!first || !last || !step || *step == 0.0) {
+		in.runtime_error(ctx.callee, "_range: Requires numbers and a non-zero step");
+		return {};
+	}
+	range = {.next = *first, .last = *last, .step = *step};
+	return {.payload = Iterator{std::make_shared<Iterator::State>(Iterator::State{.source = range})}};
+}
+
+Value Iter::operator()(Interpreter& in, CallContext ctx) const {
+	auto ret = std::shared_ptr<Iterator::State>{};
+	if (!check_arg_count(in, ctx, name_v, 1) || !get_iterable(in, ctx, name_v, ret)) { return {}; }
+	return {.payload = Iterator{std::move(ret)}};
+}
+
+Value Map::operator()(Interpreter& in, CallContext ctx) const { return make_stage(in, ctx, name_v, Iterator::State::Op::eMap); }
+
+Value Filter::operator()(Interpreter& in, CallContext ctx) const { return make_stage(in, ctx, name_v, Iterator::State::Op::eFilter); }
+
+Value Take::operator()(Interpreter& in, CallContext ctx) const {
+	auto source = std::shared_ptr<Iterator::State>{};
+	if (!check_arg_count(in, ctx, name_v, 2) || !get_iterable(in, ctx, name_v, source)) { return {}; }
+	auto const* count = std::get_if<double>(&ctx.args[1].payload);
+	if (!count || *count < 0.0) {
+		in.runtime_error(ctx.callee, "_take: Requires a count");
+		return {};
+	}
+	return {.payload = source->then(Iterator::State::Op::eTake, {}, static_cast<std::size_t>(*count))};
+}
+
+Value Zip::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 3) || !check_invocable(in, ctx, name_v, ctx.args[2])) { return {}; }
+	auto zip = Iterator::State::Zip{.lhs = Iterator::State::make(ctx.args[0]), .rhs = Iterator::State::make(ctx.args[1]), .fn = ctx.args[2]};
+	if (!zip.lhs || !zip.rhs) {
+		in.runtime_error(ctx.callee, "_zip: Requires two iterators, generators or lists");
+		return {};
+	}
+	return {.payload = Iterator{std::make_shared<Iterator::State>(Iterator::State{.source = std::move(zip)})}};
+}
+
+Value Reduce::operator()(Interpreter& in, CallContext ctx) const {
+	auto source = std::shared_ptr<Iterator::State>{};
+	if (!check_arg_count(in, ctx, name_v, 3) || !get_iterable(in, ctx, name_v, source) || !check_invocable(in, ctx, name_v, ctx.args[1])) { return {}; }
+	auto const& fn = ctx.args[1].get<Invocable>().callback;
+	Value args[2] = {std::move(ctx.args[2])};
+	while (source->next(in, ctx.callee, args[1])) { args[0] = fn(in, {ctx.callee, args}); }
+	return std::move(args[0]);
+}
+
+Value Sort::operator()(Interpreter& in, CallContext ctx) const {
+	if (ctx.args.size() != 1 && ctx.args.size() != 2) {
+		in.runtime_error(ctx.callee, "_sort: Requires (iterable[, less]) arguments");
+		return {};
+	}
+	if (ctx.args.size() == 2 && !check_invocable(in, ctx, name_v, ctx.args[1])) { return {}; }
+	auto values = std::vector<Value>{};
+	// a list is sorted in place (its nodes keep their links, values are reassigned): collect its value fields
+	auto slots = std::vector<Value*>{};
+	auto const restore = [&] {
+		for (std::size_t i = 0; i < slots.size(); ++i) { *slots[i] = std::move(values[i]); }
+	};
+	if (auto* head = std::get_if<StructInst>(&ctx.args.front().payload)) {
+		for (auto* node = head; node;) {
+			auto const value = node->fields ? node->fields->find("value") : StructInst::Fields::iterator{};
+			auto const next = node->fields ? node->fields->find("next") : StructInst::Fields::iterator{};
+			if (!node->fields || value == node->fields->end() || next == node->fields->end()) {
+				in.runtime_error(ctx.callee, "_sort: Requires a list");
+				restore();
+				return {};
+			}
+			slots.push_back(&value->second);
+			values.push_back(std::move(value->second));
+			node = std::get_if<StructInst>(&next->second.payload);
+		}
+	} else {
+		auto source = std::shared_ptr<Iterator::State>{};
+		if (!get_iterable(in, ctx, name_v, source)) { return {}; }
+		auto value = Value{};
+		while (source->next(in, ctx.callee, value)) { values.push_back(std::move(value)); }
+		if (in.is_errored()) { return {}; }
+	}
+	if (ctx.args.size() == 2) {
+		try {
+			sort::by(in, ctx.callee, values, ctx.args[1].get<Invocable>().callback);
+		} catch (...) {
+			restore();
+			throw;
+		}
+	} else if (!sort::by_default(values)) {
+		restore();
+		in.runtime_error(ctx.callee, "_sort: Requires all numbers or all strings (or a less function)");
+		return {};
+	}
+	if (!slots.empty()) {
+		restore();
+		return std::move(ctx.args.front());
+	}
+	// anything else is collected into a new List (prev left null, like _json_parse)
+	auto ret = Value{};
+	auto* tail = &ret;
+	for (auto& value : values) {
+		auto node = StructInst{};
+		node.def.name = json::list_name_v;
+		node.fields = std::make_shared<StructInst::Fields>();
+		(*node.fields)["value"] = std::move(value);
+		(*node.fields)["prev"];
+		auto& next = (*node.fields)["next"];
+		tail->payload = std::move(node);
+		tail = &next;
+	}
+	return ret;
+}
+
+Value Memoize::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2) || !check_invocable(in, ctx, name_v, ctx.args[0])) { return {}; }
+	auto const* capacity = std::get_if<double>(&ctx.args[1].payload);
+	if (!capacity || *capacity < 1.0) {
+		in.runtime_error(ctx.callee, "_memoize: Requires a capacity");
+		return {};
+	}
+	auto const& fn = ctx.args[0].get<Invocable>();
+	return {.payload = Invocable{.def = fn.def, .callback = Memoized::make(fn.callback, static_cast<std::size_t>(*capacity))}};
+}
+
+Value MemoStats::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto const* fn = std::get_if<Invocable>(&ctx.args.front().payload);
+	auto const* memo = fn ? fn->callback.target<Memoized>() : nullptr;
+	if (!memo) {
+		in.runtime_error(ctx.callee, "_memo_stats: Requires a memoized function");
+		return {};
+	}
+	auto const stats = memo->stats();
+	auto ret = StructInst{};
+	ret.def.name = "MemoStats";
+	ret.fields = std::make_shared<StructInst::Fields>();
+	(*ret.fields)["hits"].payload = static_cast<double>(stats.hits);
+	(*ret.fields)["misses"].payload = static_cast<double>(stats.misses);
+	(*ret.fields)["evictions"].payload = static_cast<double>(stats.evictions);
+	(*ret.fields)["size"].payload = static_cast<double>(stats.size);
+	return {.payload = std::move(ret)};
+}
+
+Value Open::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	if (!ctx.args.front().is_string()) {
+		in.runtime_error(ctx.callee, "_open: Requires a path");
+		return {};
+	}
+	auto reader = util::FileReader{std::string{ctx.args.front().as_string()}.c_str()};
+	// like _file("read"), a missing file is not an error: the script checks for null
+	if (!reader) { return {}; }
+	auto state = std::make_shared<FileHandle::State>();
+	state->reader = std::move(reader);
+	return {.payload = FileHandle{std::move(state)}};
+}
+
+Value ReadLine::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto* reader = get_file(in, ctx, name_v);
+	auto line = std::string_view{};
+	if (!reader || !reader->read_line(line)) { return {}; }
+	return Value::make_slice(reader->buffer(), line);
+}
+
+Value ReadChunk::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2)) { return {}; }
+	auto* reader = get_file(in, ctx, name_v);
+	if (!reader) { return {}; }
+	auto const* size = std::get_if<double>(&ctx.args[1].payload);
+	if (!size || *size < 1.0) {
+		in.runtime_error(ctx.callee, "_read_chunk: Requires a size");
+		return {};
+	}
+	auto chunk = std::string_view{};
+	if (!reader->read_chunk(chunk, static_cast<std::size_t>(*size))) { return {}; }
+	return Value::make_slice(reader->buffer(), chunk);
+}
+
+Value JsonParse::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1) || !check_strings(in, ctx, name_v, 1)) { return {}; }
+	// like _num: text that isn't valid JSON yields null
+	auto ret = Value{};
+	if (!json::parse(ctx.args.front().as_string(), ret)) { return {}; }
+	return ret;
+}
+
+Value JsonStringify::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto ret = std::string{};
+	if (!json::stringify(ctx.args.front(), ret)) {
+		in.runtime_error(ctx.callee, "_json_stringify: Value can't be represented as JSON");
+		return {};
+	}
+	return {.payload = std::move(ret)};
+}
+
+Value Field::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2)) { return {}; }
+	auto const* inst = std::get_if<StructInst>(&ctx.args[0].payload);
+	if (!inst || !ctx.args[1].is_string()) {
+		in.runtime_error(ctx.callee, "_field: Requires (instance, string) arguments");
+		return {};
+	}
+	// missing fields are null rather than an error: JSON objects don't have a fixed set of keys
+	auto const* ret = inst->find(ctx.args[1].as_string());
+	return ret ? *ret : Value{};
+}
+
+Value Serialize::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1)) { return {}; }
+	auto const* bytes = encode(in, ctx, name_v);
+	if (!bytes) { return {}; }
+	return {.payload = *bytes};
+}
+
+Value Deserialize::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1) || !check_strings(in, ctx, name_v, 1)) { return {}; }
+	// like _json_parse: bytes that aren't an encoding yield null
+	auto ret = Value{};
+	if (!serial::decode(ctx.args.front().as_string(), ret)) { return {}; }
+	return ret;
+}
+
+Value Save::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 2)) { return {}; }
+	if (!ctx.args[1].is_string()) {
+		in.runtime_error(ctx.callee, "_save: Invalid path");
+		return {};
+	}
+	auto const* bytes = encode(in, ctx, name_v);
+	if (!bytes) { return {}; }
+	return {.payload = Bool{util::write_file(std::string{ctx.args[1].as_string()}.c_str(), *bytes)}};
+}
+
+Value Load::operator()(Interpreter& in, CallContext ctx) const {
+	if (!check_arg_count(in, ctx, name_v, 1) || !check_strings(in, ctx, name_v, 1)) { return {}; }
+	// decoded straight from the mapping: the file is never read into a buffer
+	auto const text = util::TextBuf::map(std::string{ctx.args.front().as_string()}.c_str(), util::TextBuf::eSequential);
+	auto ret = Value{};
+	if (!serial::decode(text.view(), ret)) { return {}; }
+	return ret;
+}
 } // namespace toylang::intrinsics
@@ -20,7 +20,10 @@ struct Print : Intrinsic {
 };
 
 struct PrintF : Intrinsic {
+	struct Cache;
+
 	static constexpr std::string_view name_v = "_printf";
+
 	Value operator()(Interpreter& in, CallContext ctx) const override;
 };
 
@@ -34,6 +37,11 @@ struct Str : Intrinsic {
 	Value operator()(Interpreter& in, CallContext ctx) const override;
 };
 
+struct Num : Intrinsic {
+	static constexpr std::string_view name_v = "_num";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
 struct Now : Intrinsic {
 	static constexpr std::string_view name_v = "_now";
 	Value operator()(Interpreter& in, CallContext ctx) const override;
@@ -43,5 +51,196 @@ struct File : Intrinsic {
 	static constexpr std::string_view name_v = "_file";
 	Value operator()(Interpreter& in, CallContext ctx) const override;
 };
+struct Len : Intrinsic {
+	static constexpr std::string_view name_v = "_len";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Substr : Intrinsic {
+	static constexpr std::string_view name_v = "_substr";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Find : Intrinsic {
+	static constexpr std::string_view name_v = "_find";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct RFind : Intrinsic {
+	static constexpr std::string_view name_v = "_rfind";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Count : Intrinsic {
+	static constexpr std::string_view name_v = "_count";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct StartsWith : Intrinsic {
+	static constexpr std::string_view name_v = "_starts_with";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Replace : Intrinsic {
+	static constexpr std::string_view name_v = "_replace";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Split : Intrinsic {
+	static constexpr std::string_view name_v = "_split";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Trim : Intrinsic {
+	static constexpr std::string_view name_v = "_trim";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Spawn : Intrinsic {
+	static constexpr std::string_view name_v = "_spawn";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Join : Intrinsic {
+	static constexpr std::string_view name_v = "_join";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct ForEach : Intrinsic {
+	static constexpr std::string_view name_v = "_for_each";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+struct MakeChannel : Intrinsic {
+	static constexpr std::string_view name_v = "_channel";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Send : Intrinsic {
+	static constexpr std::string_view name_v = "_send";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Recv : Intrinsic {
+	static constexpr std::string_view name_v = "_recv";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct TryRecv : Intrinsic {
+	static constexpr std::string_view name_v = "_try_recv";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Close : Intrinsic {
+	static constexpr std::string_view name_v = "_close";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+struct Next : Intrinsic {
+	static constexpr std::string_view name_v = "_next";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Done : Intrinsic {
+	static constexpr std::string_view name_v = "_done";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+struct Range : Intrinsic {
+	static constexpr std::string_view name_v = "_range";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Iter : Intrinsic {
+	static constexpr std::string_view name_v = "_iter";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Map : Intrinsic {
+	static constexpr std::string_view name_v = "_map";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Filter : Intrinsic {
+	static constexpr std::string_view name_v = "_filter";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Take : Intrinsic {
+	static constexpr std::string_view name_v = "_take";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Zip : Intrinsic {
+	static constexpr std::string_view name_v = "_zip";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Reduce : Intrinsic {
+	static constexpr std::string_view name_v = "_reduce";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Sort : Intrinsic {
+	static constexpr std::string_view name_v = "_sort";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Memoize : Intrinsic {
+	static constexpr std::string_view name_v = "_memoize";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct MemoStats : Intrinsic {
+	static constexpr std::string_view name_v = "_memo_stats";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Open : Intrinsic {
+	static constexpr std::string_view name_v = "_open";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct ReadLine : Intrinsic {
+	static constexpr std::string_view name_v = "_read_line";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct ReadChunk : Intrinsic {
+	static constexpr std::string_view name_v = "_read_chunk";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct JsonParse : Intrinsic {
+	static constexpr std::string_view name_v = "_json_parse";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct JsonStringify : Intrinsic {
+	static constexpr std::string_view name_v = "_json_stringify";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Field : Intrinsic {
+	static constexpr std::string_view name_v = "_field";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Serialize : Intrinsic {
+	static constexpr std::string_view name_v = "_serialize";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Deserialize : Intrinsic {
+	static constexpr std::string_view name_v = "_deserialize";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Save : Intrinsic {
+	static constexpr std::string_view name_v = "_save";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
+
+struct Load : Intrinsic {
+	static constexpr std::string_view name_v = "_load";
+	Value operator()(Interpreter& in, CallContext ctx) const override;
+};
 } // namespace intrinsics
 } // namespace toylang
@@ -0,0 +1,133 @@
+#include <internal/file_handle.hpp>
+#include <internal/iterators.hpp>
+#include <toylang/interpreter.hpp>
+#include <toylang/util.hpp>
+#include <toylang/util/str_search.hpp>
+
+namespace toylang {
+namespace {
+template <std::size_t Count>
+Value call(Interpreter& in, Token const& at, Value const& fn, Value (&args)[Count]) {
+	return fn.get<Invocable>().callback(in, {at, args});
+}
+} // namespace
+
+std::shared_ptr<Iterator::State> Iterator::State::make(Value const& iterable) {
+	auto const visitor = Overloaded{
+		[](Iterator const& it) { return it.state ? it.state->clone() : nullptr; },
+		[](Generator const& gen) { return std::make_shared<State>(State{.source = gen}); },
+		[](FileHandle const& file) { return file.state ? std::make_shared<State>(State{.source = Lines{file}}) : nullptr; },
+		[&iterable](StructInst const&) { return std::make_shared<State>(State{.source = List{iterable}}); },
+		[](auto const&) { return std::shared_ptr<State>{}; },
+	};
+	return iterable.visit(visitor);
+}
+
+std::shared_ptr<Iterator::State> Iterator::State::clone() const {
+	auto ret = std::make_shared<State>(*this);
+	if (auto* zip = std::get_if<Zip>(&ret->source)) {
+		zip->lhs = zip->lhs->clone();
+		zip->rhs = zip->rhs->clone();
+	}
+	return ret;
+}
+
+Iterator Iterator::State::then(Op const op, Value fn, std::size_t const count) const {
+	auto ret = clone();
+	ret->stages.push_back({.op = op, .fn = std::move(fn), .remaining = count});
+	// take(0): nothing is ever read
+	if (op == Op::eTake && count == 0) { ret->ended = true; }
+	return {std::move(ret)};
+}
+
+bool Iterator::State::next(Interpreter& in, Token const& at, Value& out) {
+	while (!ended && !in.is_errored()) {
+		if (!pull(in, at, out)) {
+			ended = true;
+			break;
+		}
+		if (apply(in, at, out)) { return true; }
+	}
+	out = {};
+	exhausted = true;
+	return false;
+}
+
+bool Iterator::State::pull(Interpreter& in, Token const& at, Value& out) {
+	auto const visitor = Overloaded{
+		[&out](Range& range) {
+			if (range.step > 0.0 ? range.next >= range.last : range.next <= range.last) { return false; }
+			out.payload = range.next;
+			range.next += range.step;
+			return true;
+		},
+		[&](List& list) {
+			if (list.node.is_null()) { return false; }
+			auto const* inst = std::get_if<StructInst>(&list.node.payload);
+			auto const* value = inst ? inst->find("value") : nullptr;
+			auto const* next = inst ? inst->find("next") : nullptr;
+			if (!value || !next) {
+				in.runtime_error(at, "Iterator: Requires a list");
+				return false;
+			}
+			out = *value;
+			list.node = *next;
+			return true;
+		},
+		[&](Generator& gen) {
+			out = in.resume(at, gen);
+			// the generator's return value is not an element
+			return !gen.done();
+		},
+		[&](Zip& zip) {
+			Value args[2];
+			if (!zip.lhs->next(in, at, args[0]) || !zip.rhs->next(in, at, args[1])) { return false; }
+			out = call(in, at, zip.fn, args);
+			return true;
+		},
+		[&out](Lines& lines) {
+			auto line = std::string_view{};
+			if (!lines.file.state->reader.read_line(line)) { return false; }
+			out = Value::make_slice(lines.file.state->reader.buffer(), line);
+			return true;
+		},
+		[&out](Split& split) {
+			if (split.next > split.text.length) { return false; }
+			auto const text = split.text.view();
+			auto const end = util::find(text, split.delim, split.next);
+			auto const last = end == util::npos_v ? text.size() : end;
+			out = Value::make_slice(split.text.buffer, text.substr(split.next, last - split.next));
+			split.next = end == util::npos_v ? text.size() + 1 : end + split.delim.size();
+			return true;
+		},
+	};
+	return std::visit(visitor, source);
+}
+
+bool Iterator::State::apply(Interpreter& in, Token const& at, Value& out) {
+	for (auto& stage : stages) {
+		switch (stage.op) {
+		case Op::eMap: {
+			Value args[] = {std::move(out)};
+			out = call(in, at, stage.fn, args);
+			break;
+		}
+		case Op::eFilter: {
+			Value args[] = {out};
+			if (!call(in, at, stage.fn, args).is_truthy()) { return false; }
+			break;
+		}
+		case Op::eTake: {
+			if (stage.remaining == 0) {
+				ended = true;
+				return false;
+			}
+			// the last element still goes through later stages; nothing more is read after it
+			if (--stage.remaining == 0) { ended = true; }
+			break;
+		}
+		}
+	}
+	return true;
+}
+} // namespace toylang
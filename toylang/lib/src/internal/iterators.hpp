@@ -0,0 +1,80 @@
+#pragma once
+#include <toylang/value.hpp>
+#include <variant>
+#include <vector>
+
+namespace toylang {
+///
+/// \brief Lazy pipeline: a source followed by map / filter / take stages.
+/// Each element is pulled through every stage before the next one is read: no intermediate collections are built,
+/// and native (intrinsic) functions are called directly without going back through the interpreter.
+///
+struct Iterator::State {
+	enum class Op : std::uint8_t { eMap, eFilter, eTake };
+
+	struct Stage {
+		Op op{};
+		Value fn{};
+		std::size_t remaining{};
+	};
+
+	struct Range {
+		double next{};
+		double last{};
+		double step{1.0};
+	};
+
+	///
+	/// \brief std_list.tl List: node.value / node.next
+	///
+	struct List {
+		Value node{};
+	};
+
+	struct Zip {
+		std::shared_ptr<State> lhs{};
+		std::shared_ptr<State> rhs{};
+		Value fn{};
+	};
+
+	///
+	/// \brief Lines of an open file: copies of the iterator share (and advance) the same file, like generators
+	///
+	struct Lines {
+		FileHandle file{};
+	};
+
+	///
+	/// \brief Pieces of text between delimiters (slices of its buffer)
+	///
+	struct Split {
+		StrSlice text{};
+		std::string delim{};
+		// past text.length once the last piece has been read
+		std::size_t next{};
+	};
+
+	using Source = std::variant<Range, List, Generator, Zip, Lines, Split>;
+
+	Source source;
+	std::vector<Stage> stages{};
+	// no more elements will be read
+	bool ended{};
+	// a call to next() has come up empty (like Generator::done(): true only after the last element has been consumed)
+	bool exhausted{};
+
+	///
+	/// \brief Iterator over iterable (List, Generator, FileHandle, Iterator): existing iterators are copied, so composing leaves them untouched
+	///
+	static std::shared_ptr<State> make(Value const& iterable);
+
+	std::shared_ptr<State> clone() const;
+	Iterator then(Op op, Value fn, std::size_t count = {}) const;
+
+	bool next(Interpreter& in, Token const& at, Value& out);
+
+  private:
+	bool pull(Interpreter& in, Token const& at, Value& out);
+	bool apply(Interpreter& in, Token const& at, Value& out);
+};
+} // namespace toylang
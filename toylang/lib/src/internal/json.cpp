@@ -0,0 +1,409 @@
+#include <internal/intern.hpp>
+#include <internal/json.hpp>
+#include <toylang/util.hpp>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace toylang::json {
+namespace {
+bool is_space(char const c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+int hex_digit(char const c) {
+	if (c >= '0' && c <= '9') { return c - '0'; }
+	if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+	if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+	return -1;
+}
+
+void append_utf8(std::string& out, std::uint32_t const cp) {
+	if (cp < 0x80) {
+		out += static_cast<char>(cp);
+	} else if (cp < 0x800) {
+		out += static_cast<char>(0xc0 | (cp >> 6));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		out += static_cast<char>(0xe0 | (cp >> 12));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	} else {
+		out += static_cast<char>(0xf0 | (cp >> 18));
+		out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	}
+}
+
+///
+/// \brief Single pass recursive descent; string bodies (most of the bytes in typical documents) are scanned 16 bytes at a time
+///
+class Parser {
+  public:
+	explicit Parser(std::string_view const text) : m_text(text) {}
+
+	bool document(Value& out) {
+		if (!value(out, 0)) { return false; }
+		skip_space();
+		return m_pos == m_text.size();
+	}
+
+  private:
+	char peek() const { return m_pos < m_text.size() ? m_text[m_pos] : '\0'; }
+
+	void skip_space() {
+		while (m_pos < m_text.size() && is_space(m_text[m_pos])) { ++m_pos; }
+	}
+
+	bool consume(std::string_view const word) {
+		if (m_text.substr(m_pos, word.size()) != word) { return false; }
+		m_pos += word.size();
+		return true;
+	}
+
+	bool value(Value& out, std::size_t const depth) {
+		if (depth > max_depth_v) { return false; }
+		skip_space();
+		switch (peek()) {
+		case '{': return object(out, depth);
+		case '[': return array(out, depth);
+		case '"': {
+			if (auto str = std::string_view{}; raw_string(str)) {
+				out.payload = std::string{str};
+				return true;
+			}
+			auto str = std::string{};
+			if (!string(str)) { return false; }
+			out.payload = std::move(str);
+			return true;
+		}
+		case 't': out.payload = Bool{true}; return consume("true");
+		case 'f': out.payload = Bool{false}; return consume("false");
+		case 'n': out.payload = nullptr; return consume("null");
+		default: return number(out);
+		}
+	}
+
+	bool object(Value& out, std::size_t const depth) {
+		// {
+		++m_pos;
+		auto inst = StructInst{};
+		inst.def.name = object_name_v;
+		inst.fields = std::make_shared<StructInst::Fields>();
+		inst.fields->names = m_names;
+		skip_space();
+		if (peek() == '}') {
+			++m_pos;
+			out.payload = std::move(inst);
+			return true;
+		}
+		// sized like the previous object: arrays of objects usually share their keys
+		inst.fields->reserve(m_fields_hint);
+		inst.def.fields.reserve(m_fields_hint);
+		auto key = std::string{};
+		while (true) {
+			skip_space();
+			if (peek() != '"') { return false; }
+			auto name = std::string_view{};
+			if (!raw_string(name)) {
+				key.clear();
+				if (!string(key)) { return false; }
+				name = key;
+			}
+			skip_space();
+			if (peek() != ':') { return false; }
+			++m_pos;
+			auto field = Value{};
+			if (!value(field, depth + 1)) { return false; }
+			name = m_names->intern(name);
+			// duplicate keys: the last one wins
+			if (auto const [it, inserted] = inst.fields->insert_or_assign(name, std::move(field)); inserted) { inst.def.fields.push_back(name); }
+			skip_space();
+			if (peek() == ',') {
+				++m_pos;
+				continue;
+			}
+			if (peek() != '}') { return false; }
+			++m_pos;
+			m_fields_hint = inst.def.fields.size();
+			out.payload = std::move(inst);
+			return true;
+		}
+	}
+
+	bool array(Value& out, std::size_t const depth) {
+		// [
+		++m_pos;
+		out = {};
+		skip_space();
+		if (peek() == ']') {
+			++m_pos;
+			return true;
+		}
+		auto* tail = &out;
+		while (true) {
+			auto node = StructInst{};
+			node.def.name = list_name_v;
+			node.fields = std::make_shared<StructInst::Fields>();
+			auto& element = (*node.fields)["value"];
+			if (!value(element, depth + 1)) { return false; }
+			(*node.fields)["prev"];
+			auto& next = (*node.fields)["next"];
+			tail->payload = std::move(node);
+			tail = &next;
+			skip_space();
+			if (peek() == ',') {
+				++m_pos;
+				continue;
+			}
+			if (peek() != ']') { return false; }
+			++m_pos;
+			return true;
+		}
+	}
+
+	// end of the number starting at first per RFC 8259 (-? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?), null if malformed:
+	// from_chars alone accepts inf / nan, leading zeros, "1." ...
+	static char const* number_end(char const* it, char const* const last) {
+		auto const is_digit = [&] { return it != last && *it >= '0' && *it <= '9'; };
+		auto const digits = [&] {
+			if (!is_digit()) { return false; }
+			while (is_digit()) { ++it; }
+			return true;
+		};
+		if (it != last && *it == '-') { ++it; }
+		if (it != last && *it == '0') {
+			++it;
+		} else if (!digits()) {
+			return nullptr;
+		}
+		if (it != last && *it == '.') {
+			++it;
+			if (!digits()) { return nullptr; }
+		}
+		if (it != last && (*it == 'e' || *it == 'E')) {
+			++it;
+			if (it != last && (*it == '+' || *it == '-')) { ++it; }
+			if (!digits()) { return nullptr; }
+		}
+		return it;
+	}
+
+	bool number(Value& out) {
+		auto const* first = m_text.data() + m_pos;
+		auto const* last = number_end(first, m_text.data() + m_text.size());
+		if (!last) { return false; }
+		auto ret = double{};
+		auto const [ptr, ec] = std::from_chars(first, last, ret);
+		if (ec == std::errc::result_out_of_range) {
+			// overflow / underflow: strtod rounds to inf / 0 instead of failing
+			ret = std::strtod(std::string{first, ptr}.c_str(), nullptr);
+		} else if (ec != std::errc{}) {
+			return false;
+		}
+		m_pos += static_cast<std::size_t>(ptr - first);
+		out.payload = ret;
+		return true;
+	}
+
+	// position after the next '"', '\\' or control character (the end of text if none)
+	std::size_t scan_string(std::size_t pos) const {
+#if defined(TL_SSE2)
+		auto const quote = _mm_set1_epi8('"');
+		auto const backslash = _mm_set1_epi8('\\');
+		// bytes < 0x20: the compare is signed, so bytes >= 0x80 (negative) are excluded separately
+		auto const space = _mm_set1_epi8(0x20);
+		auto const minus_one = _mm_set1_epi8(-1);
+		for (; pos + 16 <= m_text.size(); pos += 16) {
+			auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(m_text.data() + pos));
+			auto const control = _mm_and_si128(_mm_cmplt_epi8(block, space), _mm_cmpgt_epi8(block, minus_one));
+			auto const special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)), control);
+			if (auto const mask = static_cast<std::uint32_t>(_mm_movemask_epi8(special)); mask != 0) {
+				return pos + static_cast<std::size_t>(std::countr_zero(mask));
+			}
+		}
+#endif
+		for (; pos < m_text.size(); ++pos) {
+			auto const c = static_cast<unsigned char>(m_text[pos]);
+			if (c == '"' || c == '\\' || c < 0x20) { return pos; }
+		}
+		return pos;
+	}
+
+	// a string without escapes, as a view of text (false, leaving the position unchanged, if it has any)
+	bool raw_string(std::string_view& out) {
+		auto const end = scan_string(m_pos + 1);
+		if (end >= m_text.size() || m_text[end] != '"') { return false; }
+		out = m_text.substr(m_pos + 1, end - m_pos - 1);
+		m_pos = end + 1;
+		return true;
+	}
+
+	bool string(std::string& out) {
+		// "
+		++m_pos;
+		while (true) {
+			auto const special = scan_string(m_pos);
+			out.append(m_text.substr(m_pos, special - m_pos));
+			m_pos = special;
+			switch (peek()) {
+			case '"': ++m_pos; return true;
+			case '\\': {
+				if (!escape(out)) { return false; }
+				continue;
+			}
+			// unterminated, or an unescaped control character
+			default: return false;
+			}
+		}
+	}
+
+	bool hex4(std::uint32_t& out) {
+		if (m_pos + 4 > m_text.size()) { return false; }
+		out = 0;
+		for (std::size_t i = 0; i < 4; ++i) {
+			auto const digit = hex_digit(m_text[m_pos + i]);
+			if (digit < 0) { return false; }
+			out = out * 16 + static_cast<std::uint32_t>(digit);
+		}
+		m_pos += 4;
+		return true;
+	}
+
+	bool escape(std::string& out) {
+		// backslash
+		++m_pos;
+		auto const c = peek();
+		++m_pos;
+		switch (c) {
+		case '"': out += '"'; return true;
+		case '\\': out += '\\'; return true;
+		case '/': out += '/'; return true;
+		case 'b': out += '\b'; return true;
+		case 'f': out += '\f'; return true;
+		case 'n': out += '\n'; return true;
+		case 'r': out += '\r'; return true;
+		case 't': out += '\t'; return true;
+		case 'u': {
+			auto cp = std::uint32_t{};
+			if (!hex4(cp)) { return false; }
+			// a surrogate pair: a lone surrogate (either half) is not a character
+			if (cp >= 0xdc00 && cp < 0xe000) { return false; }
+			if (cp >= 0xd800 && cp < 0xdc00) {
+				auto low = std::uint32_t{};
+				if (!consume("\\u") || !hex4(low) || low < 0xdc00 || low >= 0xe000) { return false; }
+				cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+			}
+			append_utf8(out, cp);
+			return true;
+		}
+		default: return false;
+		}
+	}
+
+	std::string_view m_text{};
+	std::size_t m_pos{};
+	std::size_t m_fields_hint{};
+	// keys of every object in this document
+	std::shared_ptr<Names> m_names{std::make_shared<Names>()};
+};
+
+void append_string(std::string& out, std::string_view const str) {
+	static constexpr char const* hex_v = "0123456789abcdef";
+	out += '"';
+	auto run = std::size_t{};
+	for (std::size_t i = 0; i < str.size(); ++i) {
+		auto const c = static_cast<unsigned char>(str[i]);
+		if (c >= 0x20 && c != '"' && c != '\\') { continue; }
+		out.append(str.substr(run, i - run));
+		run = i + 1;
+		switch (c) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default: util::append(out, "\\u00", hex_v[c >> 4], hex_v[c & 0xf]); break;
+		}
+	}
+	out.append(str.substr(run));
+	out += '"';
+}
+
+bool stringify(Value const& value, std::string& out, std::size_t const depth);
+
+bool stringify_inst(StructInst const& inst, std::string& out, std::size_t const depth) {
+	if (!inst.fields) { return false; }
+	if (inst.def.name == list_name_v) {
+		out += '[';
+		for (auto const* node = &inst; node;) {
+			auto const* element = node->find("value");
+			if (!element || !stringify(*element, out, depth + 1)) { return false; }
+			auto const* next = node->find("next");
+			node = next ? std::get_if<StructInst>(&next->payload) : nullptr;
+			if (node) { out += ','; }
+		}
+		out += ']';
+		return true;
+	}
+	out += '{';
+	auto first = true;
+	for (auto const& name : inst.def.fields) {
+		auto const* field = inst.find(name);
+		if (!field) { continue; }
+		if (!first) { out += ','; }
+		first = false;
+		append_string(out, name);
+		out += ':';
+		if (!stringify(*field, out, depth + 1)) { return false; }
+	}
+	out += '}';
+	return true;
+}
+
+bool stringify(Value const& value, std::string& out, std::size_t const depth) {
+	if (depth > max_depth_v) { return false; }
+	auto const visitor = Overloaded{
+		[&out](std::nullptr_t) {
+			out += "null";
+			return true;
+		},
+		[&out](Bool const b) {
+			out += b ? "true" : "false";
+			return true;
+		},
+		[&out, &value](double const d) {
+			// JSON has no inf / nan
+			if (!std::isfinite(d)) {
+				out += "null";
+			} else {
+				append_to(out, value);
+			}
+			return true;
+		},
+		[&out](std::string const& s) {
+			append_string(out, s);
+			return true;
+		},
+		[&out](StrSlice const& s) {
+			append_string(out, s.view());
+			return true;
+		},
+		[&out, depth](StructInst const& inst) { return stringify_inst(inst, out, depth); },
+		[](auto const&) { return false; },
+	};
+	return value.visit(visitor);
+}
+} // namespace
+
+bool parse(std::string_view const text, Value& out) { return Parser{text}.document(out); }
+
+bool stringify(Value const& value, std::string& out) { return stringify(value, out, 0); }
+} // namespace toylang::json
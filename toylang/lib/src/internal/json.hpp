@@ -0,0 +1,25 @@
+#pragma once
+#include <toylang/value.hpp>
+#include <string>
+#include <string_view>
+
+namespace toylang {
+///
+/// \brief JSON <-> Value: objects are struct instances (keys stored once per document, see Names),
+/// arrays are std_list.tl List chains (value / next; empty arrays are null), numbers are doubles.
+///
+namespace json {
+inline constexpr std::size_t max_depth_v{512};
+inline constexpr std::string_view object_name_v{"Object"};
+inline constexpr std::string_view list_name_v{"List"};
+
+///
+/// \brief Parse one JSON document (surrounded by optional whitespace); false if text is not valid JSON
+///
+bool parse(std::string_view text, Value& out);
+///
+/// \brief Append value as JSON; false if it contains something JSON can't represent (functions, tasks, ...) or nests too deeply
+///
+bool stringify(Value const& value, std::string& out);
+} // namespace json
+} // namespace toylang
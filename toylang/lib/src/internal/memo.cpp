@@ -0,0 +1,114 @@
+#include <internal/memo.hpp>
+#include <toylang/interpreter.hpp>
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace toylang {
+namespace {
+bool same_key(Value const& a, Value const& b) {
+	if (a.is_string()) { return b.is_string() && a.as_string() == b.as_string(); }
+	return a.payload.index() == b.payload.index() && a == b;
+}
+
+std::size_t hash_args(std::span<Value const> const args) {
+	auto ret = args.size();
+	for (auto const& arg : args) { ret = ret * 31 + arg.hash(); }
+	return ret;
+}
+} // namespace
+
+struct Memoized::State {
+	struct Entry {
+		std::vector<Value> args{};
+		Value result{};
+		std::size_t hash{};
+	};
+	// most recently used at the front
+	using Entries = std::list<Entry>;
+
+	Callback fn{};
+	std::size_t capacity{};
+
+	// the wrapped function runs unlocked: it may recurse through the memoized name, or be called from other tasks
+	std::mutex mutex{};
+	Entries entries{};
+	std::unordered_multimap<std::size_t, Entries::iterator> index{};
+	Stats stats{};
+
+	Entries::iterator find(std::size_t const hash, std::span<Value const> const args) {
+		auto const [first, last] = index.equal_range(hash);
+		for (auto it = first; it != last; ++it) {
+			auto const& entry = *it->second;
+			if (std::ranges::equal(entry.args, args, same_key)) { return it->second; }
+		}
+		return entries.end();
+	}
+
+	void evict() {
+		auto const last = std::prev(entries.end());
+		auto const [first, end] = index.equal_range(last->hash);
+		for (auto it = first; it != end; ++it) {
+			if (it->second != last) { continue; }
+			index.erase(it);
+			break;
+		}
+		entries.pop_back();
+		++stats.evictions;
+	}
+};
+
+Memoized Memoized::make(Callback fn, std::size_t const capacity) {
+	auto ret = Memoized{std::make_shared<State>()};
+	ret.state->fn = std::move(fn);
+	ret.state->capacity = std::max(capacity, std::size_t{1});
+	return ret;
+}
+
+Value Memoized::operator()(Interpreter& in, CallContext ctx) const {
+	auto const hash = hash_args(ctx.args);
+	{
+		auto lock = std::scoped_lock{state->mutex};
+		if (auto const it = state->find(hash, ctx.args); it != state->entries.end()) {
+			++state->stats.hits;
+			state->entries.splice(state->entries.begin(), state->entries, it);
+			// every caller gets its own copy: mutating it must not change the cache (or another task's result)
+			auto ret = it->result;
+			detach({&ret});
+			return ret;
+		}
+		++state->stats.misses;
+	}
+	auto entry = State::Entry{.args = {ctx.args.begin(), ctx.args.end()}, .hash = hash};
+	// a failed call (an intrinsic reports without throwing) is not a result: judged by this call's errors alone,
+	// an earlier one (eg a host's failed evaluate) must not turn caching off for good
+	auto const errored = in.is_errored();
+	in.m_reporter->clear_error();
+	entry.result = state->fn(in, ctx);
+	auto const failed = in.is_errored();
+	if (errored) { in.m_reporter->set_error(); }
+	if (failed) { return entry.result; }
+	// cached values outlive the call: don't let a short slice pin its whole buffer
+	// (instances are keys by identity: arguments are not copied)
+	for (auto& arg : entry.args) { compact(arg); }
+	auto ret = entry.result;
+	// the cache keeps its own copy (compacted too): a result with generators, iterators or files belongs to this task, and is not cached
+	if (!detach({&entry.result})) { return ret; }
+	auto lock = std::scoped_lock{state->mutex};
+	// a recursive / concurrent call with the same arguments may have got here first
+	if (state->find(hash, entry.args) != state->entries.end()) { return ret; }
+	if (state->entries.size() >= state->capacity) { state->evict(); }
+	state->entries.push_front(std::move(entry));
+	state->index.emplace(hash, state->entries.begin());
+	return ret;
+}
+
+Memoized::Stats Memoized::stats() const {
+	auto lock = std::scoped_lock{state->mutex};
+	auto ret = state->stats;
+	ret.size = state->entries.size();
+	return ret;
+}
+} // namespace toylang
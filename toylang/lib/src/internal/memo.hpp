@@ -0,0 +1,29 @@
+#pragma once
+#include <toylang/value.hpp>
+#include <cstdint>
+
+namespace toylang {
+///
+/// \brief Callback of a function wrapped by _memoize: results are cached by arguments, the least recently used evicted past capacity.
+/// Arguments match a cached call if each is the same type and == (see Value::hash): true and 1 are different keys.
+/// Cached results are detached copies, on store and on every hit: callers may mutate what they get.
+///
+struct Memoized {
+	struct Stats {
+		std::uint64_t hits{};
+		std::uint64_t misses{};
+		std::uint64_t evictions{};
+		std::size_t size{};
+	};
+
+	struct State;
+
+	std::shared_ptr<State> state{};
+
+	static Memoized make(Callback fn, std::size_t capacity);
+
+	Value operator()(Interpreter& in, CallContext ctx) const;
+
+	Stats stats() const;
+};
+} // namespace toylang
@@ -0,0 +1,488 @@
+#include <internal/module_cache.hpp>
+#include <toylang/util/text_buf.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace toylang {
+namespace fs = std::filesystem;
+
+namespace {
+constexpr std::uint32_t magic_v{0x434c5474}; // "tTLC"
+constexpr std::uint32_t format_version_v{2};
+constexpr std::uint32_t npos_v{0xffffffff};
+constexpr std::uint8_t null_v{0xff};
+
+enum class ExprTag : std::uint8_t { eLiteral, eGroup, eUnary, eBinary, eVar, eAssign, eLogical, eInvoke, eGet, eSet };
+enum class StmtTag : std::uint8_t { eExpr, eVar, eBlock, eIf, eWhile, eBreak, eFn, eReturn, eStruct, eYield };
+
+constexpr std::uint64_t fnv1a(std::string_view const text, std::uint64_t hash = 0xcbf29ce484222325) {
+	for (char const c : text) {
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+#if !defined(TL_BUILD_ID)
+#define TL_BUILD_ID "unknown"
+#endif
+
+// the compiler that built the interpreter (set by CMake): reproducible, unlike a timestamp.
+// Changes to the encoding itself bump format_version_v.
+constexpr std::uint64_t build_id_v = fnv1a(TL_BUILD_ID);
+
+// random per process, then thread and call: distinct between concurrent writers
+std::string unique_suffix() {
+	static auto const process = std::random_device{}();
+	static auto counter = std::atomic<std::uint64_t>{};
+	auto const thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+	return std::to_string(process) + '-' + std::to_string(thread) + '-' + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+}
+
+struct Header {
+	std::uint32_t magic{};
+	std::uint32_t version{};
+	std::uint64_t build{};
+	std::uint64_t hash{};
+	std::uint64_t size{};
+};
+
+struct Writer : Expr::Visitor, Stmt::Visitor {
+	std::string& out;
+	std::string_view text;
+
+	Writer(std::string& out, std::string_view text) : out(out), text(text) {}
+
+	template <typename T>
+	void raw(T const t) {
+		char bytes[sizeof(T)];
+		std::memcpy(bytes, &t, sizeof(T));
+		out.append(bytes, sizeof(T));
+	}
+
+	void u8(std::uint8_t const value) { raw(value); }
+	void u32(std::size_t const value) { raw(static_cast<std::uint32_t>(value)); }
+
+	void view(std::string_view const str) {
+		if (str.data() < text.data() || str.data() + str.size() > text.data() + text.size()) {
+			u32(npos_v);
+			return;
+		}
+		u32(static_cast<std::size_t>(str.data() - text.data()));
+		u32(str.size());
+	}
+
+	void token(Token const& token) {
+		u8(static_cast<std::uint8_t>(token.type));
+		view(token.lexeme);
+		u32(token.location.char_span.first);
+		u32(token.location.char_span.last);
+		u32(token.location.line);
+	}
+
+	void literal(Literal const& literal) {
+		u8(static_cast<std::uint8_t>(literal.type()));
+		switch (literal.type()) {
+		case Literal::Type::eBool: u8(literal.as_bool() ? 1 : 0); break;
+		case Literal::Type::eDouble: raw(literal.as_double()); break;
+		case Literal::Type::eString: view(literal.as_string()); break;
+		default: break;
+		}
+	}
+
+	void expr(UExpr const& expr) {
+		if (!expr) { return u8(null_v); }
+		expr->accept(*this);
+	}
+
+	void stmt(Stmt const* stmt) {
+		if (!stmt) { return u8(null_v); }
+		stmt->accept(*this);
+	}
+
+	void stmts(std::span<UStmt const> stmts) {
+		u32(stmts.size());
+		for (auto const& s : stmts) { stmt(s.get()); }
+	}
+
+	void tag(ExprTag const t) { u8(static_cast<std::uint8_t>(t)); }
+	void tag(StmtTag const t) { u8(static_cast<std::uint8_t>(t)); }
+
+	Value visit(ExprLiteral const& e) override final {
+		tag(ExprTag::eLiteral);
+		literal(e.value);
+		token(e.self);
+		return {};
+	}
+
+	Value visit(ExprGroup const& e) override final {
+		tag(ExprTag::eGroup);
+		expr(e.expr);
+		return {};
+	}
+
+	Value visit(ExprUnary const& e) override final {
+		tag(ExprTag::eUnary);
+		token(e.op);
+		expr(e.rhs);
+		return {};
+	}
+
+	Value visit(ExprBinary const& e) override final {
+		tag(ExprTag::eBinary);
+		expr(e.lhs);
+		token(e.op);
+		expr(e.rhs);
+		return {};
+	}
+
+	Value visit(ExprVar const& e) override final {
+		tag(ExprTag::eVar);
+		token(e.name);
+		return {};
+	}
+
+	Value visit(ExprAssign const& e) override final {
+		tag(ExprTag::eAssign);
+		token(e.name);
+		expr(e.value);
+		return {};
+	}
+
+	Value visit(ExprLogical const& e) override final {
+		tag(ExprTag::eLogical);
+		expr(e.lhs);
+		token(e.op);
+		expr(e.rhs);
+		return {};
+	}
+
+	Value visit(ExprInvoke const& e) override final {
+		tag(ExprTag::eInvoke);
+		expr(e.callee);
+		token(e.paren_r);
+		u32(e.args.arity);
+		for (std::size_t i = 0; i < e.args.arity; ++i) { expr(e.args.args[i]); }
+		return {};
+	}
+
+	Value visit(ExprGet const& e) override final {
+		tag(ExprTag::eGet);
+		expr(e.obj);
+		token(e.name);
+		return {};
+	}
+
+	Value visit(ExprSet const& e) override final {
+		tag(ExprTag::eSet);
+		expr(e.obj);
+		token(e.name);
+		expr(e.value);
+		return {};
+	}
+
+	void visit(StmtExpr const& s) override final {
+		tag(StmtTag::eExpr);
+		expr(s.expr);
+	}
+
+	void visit(StmtVar const& s) override final {
+		tag(StmtTag::eVar);
+		token(s.name);
+		expr(s.initializer);
+	}
+
+	void visit(StmtBlock const& s) override final {
+		tag(StmtTag::eBlock);
+		stmts(s.statements);
+	}
+
+	void visit(StmtIf const& s) override final {
+		tag(StmtTag::eIf);
+		expr(s.condition);
+		stmt(s.on.get());
+		stmt(s.off.get());
+	}
+
+	void visit(StmtWhile const& s) override final {
+		tag(StmtTag::eWhile);
+		expr(s.condition);
+		stmt(s.body.get());
+	}
+
+	void visit(StmtBreak const& s) override final {
+		tag(StmtTag::eBreak);
+		token(s.brk.token);
+	}
+
+	void visit(StmtFn const& s) override final {
+		tag(StmtTag::eFn);
+		token(s.name);
+		u32(s.params.arity);
+		for (std::size_t i = 0; i < s.params.arity; ++i) { token(s.params.args[i]); }
+		stmts(s.body);
+		u8(s.generator ? 1 : 0);
+	}
+
+	void visit(StmtReturn const& s) override final {
+		tag(StmtTag::eReturn);
+		token(s.token.token);
+		expr(s.ret);
+	}
+
+	void visit(StmtStruct const& s) override final {
+		tag(StmtTag::eStruct);
+		token(s.name);
+		u32(s.vars.size());
+		for (auto const& var : s.vars) { visit(*var); }
+	}
+
+	void visit(StmtYield const& s) override final {
+		tag(StmtTag::eYield);
+		token(s.token);
+		expr(s.value);
+	}
+};
+
+struct Reader {
+	struct Error {};
+
+	std::string_view in;
+	Source source;
+
+	template <typename T>
+	T raw() {
+		if (in.size() < sizeof(T)) { throw Error{}; }
+		auto ret = T{};
+		std::memcpy(&ret, in.data(), sizeof(T));
+		in = in.substr(sizeof(T));
+		return ret;
+	}
+
+	std::uint8_t u8() { return raw<std::uint8_t>(); }
+	std::uint32_t u32() { return raw<std::uint32_t>(); }
+
+	std::uint32_t count(std::size_t const max = npos_v) {
+		auto const ret = u32();
+		if (ret > max || ret > in.size()) { throw Error{}; }
+		return ret;
+	}
+
+	bool peek_null() {
+		if (!in.empty() && static_cast<std::uint8_t>(in.front()) == null_v) {
+			in = in.substr(1);
+			return true;
+		}
+		return false;
+	}
+
+	std::string_view view() {
+		auto const offset = u32();
+		if (offset == npos_v) { return {}; }
+		auto const size = u32();
+		if (std::size_t{offset} + size > source.text.size()) { throw Error{}; }
+		return source.text.substr(offset, size);
+	}
+
+	Token token() {
+		auto ret = Token{};
+		auto const type = u8();
+		if (type >= static_cast<std::uint8_t>(TokenType::eCOUNT_)) { throw Error{}; }
+		ret.type = static_cast<TokenType>(type);
+		ret.lexeme = view();
+		ret.location.filename = source.filename;
+		ret.location.full_text = source.text;
+		ret.location.char_span.first = u32();
+		ret.location.char_span.last = u32();
+		ret.location.line = u32();
+		return ret;
+	}
+
+	Literal literal() {
+		switch (static_cast<Literal::Type>(u8())) {
+		case Literal::Type::eNull: return nullptr;
+		case Literal::Type::eBool: return Bool{u8() != 0};
+		case Literal::Type::eDouble: return raw<double>();
+		case Literal::Type::eString: return view();
+		default: throw Error{};
+		}
+	}
+
+	UExpr expr() {
+		if (peek_null()) { return {}; }
+		switch (static_cast<ExprTag>(u8())) {
+		case ExprTag::eLiteral: {
+			auto value = literal();
+			return std::make_unique<ExprLiteral>(std::move(value), token());
+		}
+		case ExprTag::eGroup: return std::make_unique<ExprGroup>(expr());
+		case ExprTag::eUnary: {
+			auto op = token();
+			return std::make_unique<ExprUnary>(op, expr());
+		}
+		case ExprTag::eBinary: {
+			auto lhs = expr();
+			auto op = token();
+			return std::make_unique<ExprBinary>(std::move(lhs), op, expr());
+		}
+		case ExprTag::eVar: return std::make_unique<ExprVar>(token());
+		case ExprTag::eAssign: {
+			auto name = token();
+			return std::make_unique<ExprAssign>(name, expr());
+		}
+		case ExprTag::eLogical: {
+			auto lhs = expr();
+			auto op = token();
+			return std::make_unique<ExprLogical>(std::move(lhs), op, expr());
+		}
+		case ExprTag::eInvoke: {
+			auto callee = expr();
+			auto paren_r = token();
+			auto args = ExprInvoke::Args{};
+			auto const arity = count(max_args_v);
+			for (std::size_t i = 0; i < arity; ++i) { args.add(expr()); }
+			return std::make_unique<ExprInvoke>(std::move(callee), paren_r, std::move(args));
+		}
+		case ExprTag::eGet: {
+			auto obj = expr();
+			return std::make_unique<ExprGet>(std::move(obj), token());
+		}
+		case ExprTag::eSet: {
+			auto obj = expr();
+			auto name = token();
+			return std::make_unique<ExprSet>(std::move(obj), name, expr());
+		}
+		default: throw Error{};
+		}
+	}
+
+	std::vector<UStmt> stmts() {
+		auto ret = std::vector<UStmt>{};
+		auto const size = count();
+		ret.reserve(size);
+		for (std::size_t i = 0; i < size; ++i) { ret.push_back(stmt()); }
+		return ret;
+	}
+
+	UPtr<StmtVar> stmt_var() {
+		auto name = token();
+		return std::make_unique<StmtVar>(name, expr());
+	}
+
+	UStmt stmt() {
+		if (peek_null()) { return {}; }
+		switch (static_cast<StmtTag>(u8())) {
+		case StmtTag::eExpr: return std::make_unique<StmtExpr>(expr());
+		case StmtTag::eVar: return stmt_var();
+		case StmtTag::eBlock: return std::make_unique<StmtBlock>(stmts());
+		case StmtTag::eIf: {
+			auto condition = expr();
+			auto on = stmt();
+			return std::make_unique<StmtIf>(std::move(condition), std::move(on), stmt());
+		}
+		case StmtTag::eWhile: {
+			auto condition = expr();
+			return std::make_unique<StmtWhile>(std::move(condition), stmt());
+		}
+		case StmtTag::eBreak: return std::make_unique<StmtBreak>(StmtBreak::Break{token()});
+		case StmtTag::eFn: {
+			auto name = token();
+			auto params = StmtFn::Params{};
+			auto const arity = count(max_args_v);
+			for (std::size_t i = 0; i < arity; ++i) { params.add(token()); }
+			auto body = stmts();
+			return std::make_unique<StmtFn>(name, std::move(params), std::move(body), u8() != 0);
+		}
+		case StmtTag::eReturn: {
+			auto ret = StmtReturn::Return{token()};
+			return std::make_unique<StmtReturn>(ret, expr());
+		}
+		case StmtTag::eStruct: {
+			auto name = token();
+			auto vars = std::vector<UPtr<StmtVar>>{};
+			auto const size = count();
+			for (std::size_t i = 0; i < size; ++i) {
+				if (static_cast<StmtTag>(u8()) != StmtTag::eVar) { throw Error{}; }
+				vars.push_back(stmt_var());
+			}
+			return std::make_unique<StmtStruct>(name, std::move(vars));
+		}
+		case StmtTag::eYield: {
+			auto token = this->token();
+			return std::make_unique<StmtYield>(token, expr());
+		}
+		default: throw Error{};
+		}
+	}
+};
+
+Header make_header(std::string_view const text) {
+	return {.magic = magic_v, .version = format_version_v, .build = build_id_v, .hash = fnv1a(text), .size = text.size()};
+}
+} // namespace
+
+std::string module_cache::path_for(std::string_view const source_path, std::string_view const directory) {
+	auto path = fs::path{source_path};
+	if (!directory.empty()) {
+		// flatten the full source path into a unique file name within directory
+		auto name = fs::absolute(path).generic_string();
+		for (char& c : name) {
+			if (c == '/' || c == ':') { c = '_'; }
+		}
+		path = fs::path{directory} / name;
+	}
+	path += "c";
+	return path.string();
+}
+
+bool module_cache::load(Module& out, char const* path, Source const source) {
+	auto const file = util::TextBuf::map(path);
+	auto reader = Reader{file.view(), source};
+	try {
+		auto const header = reader.raw<Header>();
+		auto const expected = make_header(source.text);
+		if (header.magic != expected.magic || header.version != expected.version || header.build != expected.build) { return false; }
+		if (header.hash != expected.hash || header.size != expected.size) { return false; }
+		auto module = Module{};
+		auto const imports = reader.count();
+		for (std::size_t i = 0; i < imports; ++i) { module.imports.push_back(reader.token()); }
+		module.stmts = reader.stmts();
+		if (!reader.in.empty()) { return false; }
+		out = std::move(module);
+		return true;
+	} catch (Reader::Error const&) {}
+	return false;
+}
+
+bool module_cache::save(char const* path, Source const source, std::span<Token const> imports, std::span<UStmt const> stmts) {
+	if (source.text.size() >= npos_v) { return false; }
+	auto out = std::string{};
+	auto writer = Writer{out, source.text};
+	writer.raw(make_header(source.text));
+	writer.u32(imports.size());
+	for (auto const& token : imports) { writer.token(token); }
+	writer.stmts(stmts);
+	auto ec = std::error_code{};
+	if (auto const parent = fs::path{path}.parent_path(); !parent.empty()) { fs::create_directories(parent, ec); }
+	// write to a temporary and rename, so concurrent readers never observe a partial file.
+	// Each writer has its own (other processes / threads may be saving the same module): the last rename wins, whole.
+	auto const temp = std::string{path} + '.' + unique_suffix() + ".tmp";
+	{
+		auto file = std::ofstream(temp, std::ios::binary);
+		if (file) { file.write(out.data(), static_cast<std::streamsize>(out.size())); }
+		if (!file) {
+			fs::remove(temp, ec);
+			return false;
+		}
+	}
+	fs::rename(temp, path, ec);
+	if (ec) { fs::remove(temp, ec); }
+	return !ec;
+}
+} // namespace toylang
@@ -0,0 +1,25 @@
+#pragma once
+#include <toylang/source.hpp>
+#include <toylang/stmt.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace toylang {
+///
+/// \brief Parsed module: import paths followed by top-level statements
+///
+struct Module {
+	std::vector<Token> imports{};
+	std::vector<UStmt> stmts{};
+};
+
+///
+/// \brief Serialized modules (.tlc), keyed by a hash of the source text and the interpreter build
+///
+namespace module_cache {
+std::string path_for(std::string_view source_path, std::string_view directory);
+bool load(Module& out, char const* path, Source source);
+bool save(char const* path, Source source, std::span<Token const> imports, std::span<UStmt const> stmts);
+} // namespace module_cache
+} // namespace toylang
@@ -0,0 +1,9 @@
+#include <internal/scheduler.hpp>
+#include <thread>
+
+namespace toylang {
+util::ThreadPool& scheduler::pool() {
+	static auto ret = util::ThreadPool{std::thread::hardware_concurrency()};
+	return ret;
+}
+} // namespace toylang
@@ -0,0 +1,11 @@
+#pragma once
+#include <toylang/util/thread_pool.hpp>
+
+namespace toylang {
+///
+/// \brief Workers shared by every Interpreter in the process (tasks, channel waits)
+///
+namespace scheduler {
+util::ThreadPool& pool();
+} // namespace scheduler
+} // namespace toylang
@@ -0,0 +1,279 @@
+#include <internal/intern.hpp>
+#include <internal/serial.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace toylang::serial {
+namespace {
+constexpr std::uint32_t magic_v{0x56544c74}; // "tLTV"
+constexpr std::size_t max_names_v{1 << 20};
+
+///
+/// \brief Encoding: magic, then values depth first. Each value is a tag followed by:
+/// eInt: zigzag varint (integral doubles), eDouble: 8 bytes, eString: varint size + bytes,
+/// eInst / eShared: name, field count, then the field names followed by the values,
+/// eRef: varint index of an earlier eShared instance (the only ones that can be reached more than once: their fields have other owners).
+/// Names (struct names, field keys) are a varint (index << 1 | 1) if seen before, otherwise (size << 1) + bytes.
+///
+enum class Tag : std::uint8_t { eNull, eFalse, eTrue, eInt, eDouble, eString, eInst, eShared, eRef };
+
+// names are mostly the same few views (keys stored once per document, StructDef fields): looked up by identity, not contents
+struct ViewHash {
+	std::size_t operator()(std::string_view const str) const {
+		return std::hash<char const*>{}(str.data()) ^ (str.size() * 0x9e3779b97f4a7c15);
+	}
+};
+
+struct ViewEqual {
+	bool operator()(std::string_view const a, std::string_view const b) const { return a.data() == b.data() && a.size() == b.size(); }
+};
+
+struct Writer {
+	std::string& out;
+	std::unordered_map<std::string_view, std::size_t, ViewHash, ViewEqual> names{};
+	std::unordered_map<StructInst::Fields const*, std::size_t> instances{};
+
+	void u8(std::uint8_t const value) { out += static_cast<char>(value); }
+	void tag(Tag const t) { u8(static_cast<std::uint8_t>(t)); }
+
+	void varint(std::uint64_t value) {
+		while (value >= 0x80) {
+			u8(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		u8(static_cast<std::uint8_t>(value));
+	}
+
+	void name(std::string_view const str) {
+		if (auto const it = names.find(str); it != names.end()) { return varint(it->second << 1 | 1); }
+		names.emplace(str, names.size());
+		varint(str.size() << 1);
+		out.append(str);
+	}
+
+	void number(double const d) {
+		// integral values (the common case) are a zigzag varint: 1-3 bytes instead of 8
+		static constexpr auto int_max_v = static_cast<double>(std::int64_t{1} << 53);
+		if (d < int_max_v && d > -int_max_v && d == std::trunc(d) && !(d == 0.0 && std::signbit(d))) {
+			auto const i = static_cast<std::int64_t>(d);
+			tag(Tag::eInt);
+			varint((static_cast<std::uint64_t>(i) << 1) ^ static_cast<std::uint64_t>(i >> 63));
+			return;
+		}
+		tag(Tag::eDouble);
+		char bytes[sizeof(double)];
+		std::memcpy(bytes, &d, sizeof(double));
+		out.append(bytes, sizeof(double));
+	}
+
+	void string(std::string_view const str) {
+		tag(Tag::eString);
+		varint(str.size());
+		out.append(str);
+	}
+
+	bool value(Value const& root) {
+		// explicit stack: long chains (lists) would otherwise recurse once per node
+		auto pending = std::vector<Value const*>{&root};
+		auto fields = std::vector<Value const*>{};
+		while (!pending.empty()) {
+			auto const& value = *pending.back();
+			pending.pop_back();
+			auto const visitor = Overloaded{
+				[this](std::nullptr_t) {
+					tag(Tag::eNull);
+					return true;
+				},
+				[this](Bool const b) {
+					tag(b ? Tag::eTrue : Tag::eFalse);
+					return true;
+				},
+				[this](double const d) {
+					number(d);
+					return true;
+				},
+				[this](std::string const& s) {
+					string(s);
+					return true;
+				},
+				[this](StrSlice const& s) {
+					string(s.view());
+					return true;
+				},
+				[&](StructInst const& inst) {
+					if (!inst.fields) { return false; }
+					// sole owner: this is the only path to the instance, it needn't be remembered
+					if (inst.fields.use_count() == 1) {
+						tag(Tag::eInst);
+					} else {
+						if (auto const it = instances.find(inst.fields.get()); it != instances.end()) {
+							tag(Tag::eRef);
+							varint(it->second);
+							return true;
+						}
+						instances.emplace(inst.fields.get(), instances.size());
+						tag(Tag::eShared);
+					}
+					name(inst.def.name);
+					varint(inst.fields->size());
+					// declaration order first (kept by decode), then any others
+					fields.clear();
+					for (auto const& key : inst.def.fields) {
+						if (auto const* field = inst.find(key)) {
+							name(key);
+							fields.push_back(field);
+						}
+					}
+					for (auto const& [key, field] : *inst.fields) {
+						if (fields.size() == inst.fields->size()) { break; }
+						if (std::find(inst.def.fields.begin(), inst.def.fields.end(), key) != inst.def.fields.end()) { continue; }
+						name(key);
+						fields.push_back(&field);
+					}
+					// popped (encoded) in field order
+					pending.insert(pending.end(), fields.rbegin(), fields.rend());
+					return true;
+				},
+				[](auto const&) { return false; },
+			};
+			if (!value.visit(visitor)) { return false; }
+		}
+		return true;
+	}
+};
+
+struct Reader {
+	struct Error {};
+
+	std::string_view in;
+	std::vector<std::string_view> names{};
+	std::vector<StructInst> instances{};
+	// storage of names: shared by every instance decoded
+	std::shared_ptr<Names> storage{std::make_shared<Names>()};
+
+	std::uint8_t u8() {
+		if (in.empty()) { throw Error{}; }
+		auto const ret = static_cast<std::uint8_t>(in.front());
+		in.remove_prefix(1);
+		return ret;
+	}
+
+	std::uint64_t varint() {
+		auto ret = std::uint64_t{};
+		for (int shift = 0; shift < 64; shift += 7) {
+			auto const byte = u8();
+			ret |= std::uint64_t{byte & 0x7fu} << shift;
+			if ((byte & 0x80) == 0) { return ret; }
+		}
+		throw Error{};
+	}
+
+	std::string_view bytes(std::uint64_t const size) {
+		if (size > in.size()) { throw Error{}; }
+		auto const ret = in.substr(0, static_cast<std::size_t>(size));
+		in.remove_prefix(static_cast<std::size_t>(size));
+		return ret;
+	}
+
+	std::string_view name() {
+		auto const header = varint();
+		if (header & 1) {
+			if ((header >> 1) >= names.size()) { throw Error{}; }
+			return names[static_cast<std::size_t>(header >> 1)];
+		}
+		if (names.size() >= max_names_v) { throw Error{}; }
+		return names.emplace_back(storage->intern(bytes(header >> 1)));
+	}
+
+	void value(Value& root) {
+		auto pending = std::vector<Value*>{&root};
+		auto fields = std::vector<Value*>{};
+		while (!pending.empty()) {
+			auto& out = *pending.back();
+			pending.pop_back();
+			switch (auto const tag = static_cast<Tag>(u8())) {
+			case Tag::eNull: out = {}; break;
+			case Tag::eFalse: out.payload = Bool{false}; break;
+			case Tag::eTrue: out.payload = Bool{true}; break;
+			case Tag::eInt: {
+				auto const zigzag = varint();
+				out.payload = static_cast<double>(static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1));
+				break;
+			}
+			case Tag::eDouble: {
+				auto ret = double{};
+				std::memcpy(&ret, bytes(sizeof(double)).data(), sizeof(double));
+				out.payload = ret;
+				break;
+			}
+			case Tag::eString: out.payload = std::string{bytes(varint())}; break;
+			case Tag::eInst:
+			case Tag::eShared: {
+				auto const shared = tag == Tag::eShared;
+				auto inst = StructInst{};
+				inst.def.name = name();
+				inst.fields = std::make_shared<StructInst::Fields>();
+				inst.fields->names = storage;
+				auto const count = varint();
+				// every field takes at least two bytes (name, value)
+				if (count > in.size()) { throw Error{}; }
+				inst.def.fields.reserve(static_cast<std::size_t>(count));
+				inst.fields->reserve(static_cast<std::size_t>(count));
+				fields.clear();
+				for (std::uint64_t i = 0; i < count; ++i) {
+					auto const key = name();
+					auto const [it, inserted] = inst.fields->try_emplace(key);
+					if (!inserted) { throw Error{}; }
+					inst.def.fields.push_back(key);
+					fields.push_back(&it->second);
+				}
+				// registered before its fields are read: they may refer back to it
+				if (shared) { instances.push_back(inst); }
+				out.payload = std::move(inst);
+				pending.insert(pending.end(), fields.rbegin(), fields.rend());
+				break;
+			}
+			case Tag::eRef: {
+				auto const index = varint();
+				if (index >= instances.size()) { throw Error{}; }
+				out.payload = instances[static_cast<std::size_t>(index)];
+				break;
+			}
+			default: throw Error{};
+			}
+		}
+	}
+};
+} // namespace
+
+bool encode(Value const& value, std::string& out) {
+	auto const size = out.size();
+	char magic[sizeof(magic_v)];
+	std::memcpy(magic, &magic_v, sizeof(magic_v));
+	out.append(magic, sizeof(magic));
+	if (Writer{out}.value(value)) { return true; }
+	out.resize(size);
+	return false;
+}
+
+bool decode(std::string_view bytes, Value& out) {
+	if (bytes.size() < sizeof(magic_v) || std::memcmp(bytes.data(), &magic_v, sizeof(magic_v)) != 0) { return false; }
+	auto reader = Reader{bytes.substr(sizeof(magic_v))};
+	try {
+		reader.value(out);
+	} catch (Reader::Error const&) {
+		out = {};
+		return false;
+	}
+	// trailing bytes: not (only) an encoding
+	if (!reader.in.empty()) {
+		out = {};
+		return false;
+	}
+	return true;
+}
+} // namespace toylang::serial
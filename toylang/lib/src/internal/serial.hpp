@@ -0,0 +1,21 @@
+#pragma once
+#include <toylang/value.hpp>
+#include <string>
+#include <string_view>
+
+namespace toylang {
+///
+/// \brief Compact binary encoding of Value graphs: null / bools / numbers / strings / struct instances.
+/// Instances reachable more than once (shared, or cyclic like std_list.tl prev / next) are encoded once and referenced after that.
+///
+namespace serial {
+///
+/// \brief Append value's encoding to out (which may be reused across calls); false if it contains a function, task, channel, ...
+///
+bool encode(Value const& value, std::string& out);
+///
+/// \brief Decode straight from bytes (eg a mapped file); false if they're truncated / not an encoding
+///
+bool decode(std::string_view bytes, Value& out);
+} // namespace serial
+} // namespace toylang
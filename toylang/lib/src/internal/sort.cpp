@@ -0,0 +1,116 @@
+#include <internal/scheduler.hpp>
+#include <internal/sort.hpp>
+#include <toylang/interpreter.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <span>
+#include <string_view>
+#include <thread>
+
+namespace toylang::sort {
+namespace {
+///
+/// \brief Run fn(0) .. fn(count - 1): all but the first on the pool, helping with queued tasks until they complete
+///
+template <typename F>
+void run_all(std::size_t const count, F const& fn) {
+	auto& pool = scheduler::pool();
+	auto remaining = std::atomic<std::size_t>{count - 1};
+	for (std::size_t i = 1; i < count; ++i) {
+		pool.push([&fn, &remaining, i] {
+			fn(i);
+			remaining.fetch_sub(1, std::memory_order_release);
+		});
+	}
+	fn(0);
+	while (remaining.load(std::memory_order_acquire) > 0) {
+		if (!pool.try_run()) { std::this_thread::yield(); }
+	}
+}
+
+///
+/// \brief std::sort (introsort) below the threshold / on a single worker, otherwise a merge sort of per-worker chunks
+///
+template <typename T, typename Cmp>
+void parallel_sort(std::span<T> const range, Cmp const cmp) {
+	auto const workers = scheduler::pool().size();
+	auto const chunks = std::bit_floor(std::min(workers, range.size() / parallel_threshold_v));
+	if (chunks < 2) {
+		std::sort(range.begin(), range.end(), cmp);
+		return;
+	}
+	auto const bound = [&](std::size_t const chunk) { return range.begin() + static_cast<std::ptrdiff_t>(range.size() * chunk / chunks); };
+	run_all(chunks, [&](std::size_t const chunk) { std::sort(bound(chunk), bound(chunk + 1), cmp); });
+	// pairwise merges: half as many (each twice as long) every pass
+	for (std::size_t width = 1; width < chunks; width *= 2) {
+		run_all(chunks / (width * 2), [&](std::size_t const pair) {
+			auto const first = pair * width * 2;
+			std::inplace_merge(bound(first), bound(first + width), bound(first + width * 2), cmp);
+		});
+	}
+}
+
+bool sort_numbers(std::vector<Value>& values) {
+	auto keys = std::vector<double>{};
+	keys.reserve(values.size());
+	for (auto const& value : values) {
+		auto const* number = std::get_if<double>(&value.payload);
+		if (!number) { return false; }
+		keys.push_back(*number);
+	}
+	// NaN is unordered: keep it out of the comparisons, at the back
+	auto const last = std::partition(keys.begin(), keys.end(), [](double const d) { return !std::isnan(d); });
+	parallel_sort(std::span{keys.begin(), last}, std::less<>{});
+	for (std::size_t i = 0; i < keys.size(); ++i) { values[i].payload = keys[i]; }
+	return true;
+}
+
+bool sort_strings(std::vector<Value>& values) {
+	struct Key {
+		std::string_view text{};
+		std::size_t index{};
+	};
+	auto keys = std::vector<Key>{};
+	keys.reserve(values.size());
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		if (!values[i].is_string()) { return false; }
+		keys.push_back({values[i].as_string(), i});
+	}
+	parallel_sort(std::span{keys}, [](Key const& a, Key const& b) { return a.text < b.text; });
+	// the views point into values: only move them once the sort is done
+	auto sorted = std::vector<Value>{};
+	sorted.reserve(values.size());
+	for (auto const& key : keys) { sorted.push_back(std::move(values[key.index])); }
+	values = std::move(sorted);
+	return true;
+}
+} // namespace
+
+bool by_default(std::vector<Value>& values) {
+	if (values.empty()) { return true; }
+	if (values.front().contains<double>()) { return sort_numbers(values); }
+	if (values.front().is_string()) { return sort_strings(values); }
+	return false;
+}
+
+void by(Interpreter& in, Token const& at, std::vector<Value>& values, Callback const& less) {
+	// sort indices: a throwing comparator must not leave values half moved.
+	// stable_sort (merge based) also stays in bounds for inconsistent comparators, unlike std::sort.
+	auto order = std::vector<std::size_t>(values.size());
+	for (std::size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+	Value args[2];
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t const a, std::size_t const b) {
+		// an intrinsic comparator may report an error without throwing: stop calling it
+		if (in.is_errored()) { return false; }
+		args[0] = values[a];
+		args[1] = values[b];
+		return less(in, {at, args}).is_truthy();
+	});
+	auto sorted = std::vector<Value>{};
+	sorted.reserve(values.size());
+	for (auto const index : order) { sorted.push_back(std::move(values[index])); }
+	values = std::move(sorted);
+}
+} // namespace toylang::sort
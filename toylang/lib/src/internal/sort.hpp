@@ -0,0 +1,25 @@
+#pragma once
+#include <toylang/value.hpp>
+#include <vector>
+
+namespace toylang {
+///
+/// \brief Sorting Values natively: the default ordering (like <) and script comparators
+///
+namespace sort {
+///
+/// \brief Ranges at least twice this long are sorted in chunks on the scheduler's pool and then merged
+///
+inline constexpr std::size_t parallel_threshold_v{1 << 16};
+
+///
+/// \brief Sort by the ordering of < : all numbers (NaNs last) or all strings; false (values untouched) if they mix types
+///
+bool by_default(std::vector<Value>& values);
+///
+/// \brief Stable sort by less(a, b) (a script function: truthy if a goes before b).
+/// Values are only reordered once every comparison has returned: an error (thrown) leaves them untouched.
+///
+void by(Interpreter& in, Token const& at, std::vector<Value>& values, Callback const& less);
+} // namespace sort
+} // namespace toylang
@@ -1,10 +1,17 @@
+#include <internal/batch_plan.hpp>
 #include <internal/intrinsics.hpp>
+#include <internal/module_cache.hpp>
+#include <internal/scheduler.hpp>
 #include <toylang/interpreter.hpp>
 #include <toylang/parser.hpp>
 #include <toylang/stmt.hpp>
 #include <toylang/util.hpp>
+#include <algorithm>
+#include <atomic>
 #include <compare>
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
 #include <span>
 #include <utility>
 
@@ -12,6 +19,19 @@ namespace toylang {
 namespace {
 struct EvalError {};
 
+// a few KiB of native stack per call: stays well within the default 8 MiB of the main / worker threads
+constexpr std::uint32_t max_call_depth_v{2048};
+
+struct CallDepth {
+	std::uint32_t& depth;
+
+	explicit CallDepth(std::uint32_t& depth) : depth(++depth) {}
+	~CallDepth() { --depth; }
+
+	CallDepth(CallDepth const&) = delete;
+	CallDepth& operator=(CallDepth const&) = delete;
+};
+
 Diagnostic make_diagnostic(Token const& token, std::string_view message, TokenType expected, Diagnostic::Type type) {
 	return Diagnostic{
 		.token = token,
@@ -37,6 +57,32 @@ void expect_assignable(util::Reporter* reporter, Token const& name, Value const&
 }
 } // namespace
 
+struct Task::State {
+	enum class Status : std::uint8_t { ePending, eRunning, eDone };
+
+	// inputs: released once the call completes
+	std::shared_ptr<Interpreter::Image> image{};
+	Interpreter::Clock::time_point deadline{};
+	Token at{};
+	Value callee{};
+	std::vector<Value> args{};
+
+	std::atomic<Status> status{};
+	std::mutex mutex{};
+	std::condition_variable done{};
+	Value result{};
+	std::string output{};
+	std::string diagnostics{};
+	bool failed{};
+	std::atomic<bool> forwarded{};
+
+	void wait() {
+		Interpreter::run(*this);
+		auto lock = std::unique_lock{mutex};
+		done.wait(lock, [this] { return status == Status::eDone; });
+	}
+};
+
 struct Interpreter::Eval : Expr::Visitor {
 	Interpreter& interpreter;
 
@@ -78,6 +124,7 @@ struct Interpreter::Exec : Stmt::Visitor {
 	void visit(StmtFn const& stmt) override final;
 	void visit(StmtReturn const& stmt) override final;
 	void visit(StmtStruct const& stmt) override final;
+	void visit(StmtYield const& stmt) override final;
 
 	Value evaluate(Expr const* expr);
 	void execute(Stmt const& stmt);
@@ -85,6 +132,104 @@ struct Interpreter::Exec : Stmt::Visitor {
 	void execute_block(std::span<UStmt const> stmt);
 };
 
+struct Generator::State {
+	///
+	/// \brief Position in the body: a block (next statement), a loop (re-test its condition), or the function body itself
+	///
+	struct Step {
+		StmtBlock const* block{};
+		StmtWhile const* loop{};
+		std::size_t next{};
+	};
+
+	StmtFn const* decl{};
+	Environment::Suspended frame{};
+	// capacity is retained across yields: resuming does not allocate
+	std::vector<Step> steps{};
+	bool running{};
+	bool done{};
+};
+
+bool Generator::done() const { return !state || state->done; }
+
+///
+/// \brief Stackless executor for generator bodies: blocks / if / while / break / return / yield are tracked in
+/// Generator::State::steps rather than on the native stack, so a yield returns to the caller and next() carries on from there.
+/// Every other statement runs through Exec.
+///
+struct Interpreter::Resume : Stmt::Visitor {
+	Interpreter& interpreter;
+	Generator::State& state;
+	Exec exec;
+	Value out{};
+	bool suspended{};
+
+	Resume(Interpreter& interpreter, Generator::State& state) : interpreter(interpreter), state(state), exec(interpreter) {}
+
+	void visit(StmtExpr const& stmt) override final { exec.visit(stmt); }
+	void visit(StmtVar const& stmt) override final { exec.visit(stmt); }
+	void visit(StmtFn const& stmt) override final { exec.visit(stmt); }
+	void visit(StmtStruct const& stmt) override final { exec.visit(stmt); }
+
+	void visit(StmtBlock const& stmt) override final {
+		interpreter.m_environment.begin_scope();
+		state.steps.push_back({.block = &stmt});
+	}
+
+	void visit(StmtIf const& stmt) override final {
+		auto const* branch = exec.evaluate(stmt.condition.get()).is_truthy() ? stmt.on.get() : stmt.off.get();
+		if (branch) { branch->accept(*this); }
+	}
+
+	void visit(StmtWhile const& stmt) override final { state.steps.push_back({.loop = &stmt}); }
+
+	void visit(StmtBreak const& stmt) override final {
+		while (!state.steps.empty()) {
+			auto const step = state.steps.back();
+			pop();
+			if (step.loop) { return; }
+		}
+		interpreter.runtime_error(stmt.brk.token, "Unexpected break outside of any loops");
+		throw EvalError{};
+	}
+
+	void visit(StmtReturn const& stmt) override final {
+		out = stmt.ret ? exec.evaluate(stmt.ret.get()) : Value{};
+		while (!state.steps.empty()) { pop(); }
+		suspended = true;
+	}
+
+	void visit(StmtYield const& stmt) override final {
+		out = stmt.value ? exec.evaluate(stmt.value.get()) : Value{};
+		suspended = true;
+	}
+
+	void pop() {
+		if (state.steps.back().block) { interpreter.m_environment.end_scope(); }
+		state.steps.pop_back();
+	}
+
+	void step() {
+		auto& top = state.steps.back();
+		if (top.loop) {
+			auto const& loop = *top.loop;
+			if (interpreter.is_errored() || !exec.evaluate(loop.condition.get()).is_truthy()) {
+				state.steps.pop_back();
+				return;
+			}
+			interpreter.tick({});
+			loop.body->accept(*this);
+			return;
+		}
+		auto const statements = top.block ? std::span{top.block->statements} : std::span{state.decl->body};
+		if (top.next == statements.size()) {
+			pop();
+			return;
+		}
+		statements[top.next++]->accept(*this);
+	}
+};
+
 Interpreter::Eval::Eval(Interpreter& interpreter) : interpreter(interpreter) {}
 
 Value Interpreter::Eval::evaluate(Interpreter& interprter, Expr const* expr) {
@@ -95,7 +240,10 @@ Value Interpreter::Eval::evaluate(Interpreter& interprter, Expr const* expr) {
 
 Value Interpreter::Eval::evaluate(Expr const& expr) { return expr.accept(*this); }
 
-Value Interpreter::Eval::visit(ExprLiteral const& expr) { return Value::make(expr.value); }
+Value Interpreter::Eval::visit(ExprLiteral const& expr) {
+	if (expr.text) { return Value::make_slice(expr.text, *expr.text); }
+	return Value::make(expr.value);
+}
 
 Value Interpreter::Eval::visit(ExprGroup const& expr) {
 	if (expr.expr) { return evaluate(*expr.expr); }
@@ -146,7 +294,7 @@ Value Interpreter::Eval::visit(ExprBinary const& expr) {
 }
 
 Value Interpreter::Eval::visit(ExprVar const& expr) {
-	auto* bound = interpreter.m_environment.find(std::string{expr.name.lexeme});
+	auto* bound = interpreter.m_environment.find(expr.name.lexeme);
 	if (!bound) {
 		if (interpreter.m_reporter) { (*interpreter.m_reporter)(make_runtime_error(expr.name, "Undefined variable")); }
 		throw EvalError{};
@@ -155,7 +303,7 @@ Value Interpreter::Eval::visit(ExprVar const& expr) {
 }
 
 Value Interpreter::Eval::visit(ExprAssign const& expr) {
-	auto* bound = interpreter.m_environment.find(std::string{expr.name.lexeme});
+	auto* bound = interpreter.m_environment.find(expr.name.lexeme);
 	if (!bound) {
 		if (interpreter.m_reporter) { (*interpreter.m_reporter)(make_runtime_error(expr.name, "Undefined variable")); }
 		return {};
@@ -271,8 +419,19 @@ bool Interpreter::Eval::try_arithmetic(Value const& lhs, Value const& rhs, ExprB
 	case TokenType::ePlus: {
 		if (lhs.contains<double>() && rhs.contains<double>()) {
 			out.payload = lhs.get<double>() + rhs.get<double>();
-		} else if (lhs.contains<std::string>() && rhs.contains<std::string>()) {
-			out.payload = std::move(lhs.get<std::string>()) + std::move(rhs.get<std::string>());
+		} else if (lhs.is_string() && rhs.is_string()) {
+			auto const l = lhs.as_string();
+			auto const r = rhs.as_string();
+			auto str = std::string{};
+			str.reserve(l.size() + r.size());
+			util::append(str, l, r);
+			if (str.size() <= Value::small_string_v) {
+				out.payload = std::move(str);
+			} else {
+				// shared: later copies of the value (variable reads, arguments) don't copy the characters
+				auto const buffer = std::make_shared<std::string const>(std::move(str));
+				out = Value::make_slice(buffer, *buffer);
+			}
 		} else {
 			if (interpreter.m_reporter) { (*interpreter.m_reporter)(make_runtime_error(expr.op, "Invalid operands to binary expression")); }
 			throw EvalError{};
@@ -299,7 +458,7 @@ bool Interpreter::Eval::try_equality(Value const& lhs, Value const& rhs, ExprBin
 
 bool Interpreter::Eval::try_comparison(Value const& lhs, Value const& rhs, ExprBinary const& expr, Value& out) {
 	auto compare = [this, op = expr.op](Value const& a, Value const& b) -> std::partial_ordering {
-		bool const are_str = a.contains<std::string>() && b.contains<std::string>();
+		bool const are_str = a.is_string() && b.is_string();
 		bool const are_double = a.contains<double>() && b.contains<double>();
 		if (!are_str) {
 			if (!are_double) {
@@ -308,7 +467,7 @@ bool Interpreter::Eval::try_comparison(Value const& lhs, Value const& rhs, ExprB
 			}
 			return a.get<double>() <=> b.get<double>();
 		}
-		return a.get<std::string>() <=> b.get<std::string>();
+		return a.as_string() <=> b.as_string();
 	};
 	switch (expr.op.type) {
 	case TokenType::eLt: {
@@ -366,7 +525,10 @@ void Interpreter::Exec::visit(StmtIf const& stmt) {
 
 void Interpreter::Exec::visit(StmtWhile const& stmt) {
 	try {
-		while (evaluate(stmt.condition.get()).is_truthy()) { stmt.body->accept(*this); }
+		while (!interpreter.is_errored() && evaluate(stmt.condition.get()).is_truthy()) {
+			interpreter.tick({});
+			stmt.body->accept(*this);
+		}
 	} catch (StmtBreak::Break const& brk) {}
 }
 
@@ -375,36 +537,55 @@ void Interpreter::Exec::visit(StmtBreak const& stmt) { throw StmtBreak::Break{st
 void Interpreter::Exec::visit(StmtFn const& stmt) {
 	struct Invoker {
 		StmtFn const* decl{};
-		util::Notifier* notifier{};
 
 		Value operator()(Interpreter& in, CallContext ctx) {
 			auto& [callee, values] = ctx;
-			// auto scope = Environment2::Scope{in.m_environment};
-			auto stack_frame = Environment::Frame{in.m_environment};
+			in.tick(callee);
+			// calls recurse on the native stack: bail before it runs out
+			if (in.m_depth >= max_call_depth_v) {
+				in.runtime_error(callee, "Stack overflow");
+				throw EvalError{};
+			}
+			auto const depth = CallDepth{in.m_depth};
 			if (decl->params.arity != values.size()) {
-				if (notifier) {
+				if (in.m_reporter) {
 					auto err = std::string{"Mismatched argument count: expected "};
 					util::append(err, std::to_string(decl->params.arity), " passed: ", std::to_string(values.size()));
-					(*notifier)(make_runtime_error(callee, err));
+					(*in.m_reporter)(make_runtime_error(callee, err));
 				}
 				return {};
 			}
+			if (decl->generator) { return make_generator(in, values); }
+			// auto scope = Environment2::Scope{in.m_environment};
+			auto stack_frame = Environment::Frame{in.m_environment};
 			for (std::size_t i = 0; i < values.size(); ++i) { in.define(decl->params.args[i], std::move(values[i])); }
 			try {
 				Exec{in}.execute_block(decl->body);
 			} catch (StmtReturn::Return const&) {
-				if (auto* ret = in.m_environment.find("<ret>")) { return std::move(*ret); }
+				return std::exchange(in.m_returned, {});
 			}
 			return {};
 		}
+
+		Value make_generator(Interpreter& in, std::span<Value> values) const {
+			// the body does not run yet: parameters are bound in a new frame, which is parked in the generator
+			auto state = std::make_shared<Generator::State>();
+			state->decl = decl;
+			state->steps.push_back({});
+			in.m_environment.push_frame();
+			for (std::size_t i = 0; i < values.size(); ++i) { in.define(decl->params.args[i], std::move(values[i])); }
+			in.m_environment.suspend(state->frame);
+			return {.payload = Generator{std::move(state)}};
+		}
 	};
 	auto value = Value{};
-	value.payload = Invocable{stmt.name, Invoker{&stmt, interpreter.m_reporter.get()}};
+	value.payload = Invocable{stmt.name, Invoker{&stmt}};
 	interpreter.define(stmt.name, std::move(value));
 }
 
 void Interpreter::Exec::visit(StmtReturn const& stmt) {
-	if (stmt.ret) { interpreter.m_environment.define("<ret>", evaluate(stmt.ret.get())); }
+	// not stored in the environment: the scope of an enclosing block would be gone by the time the call returns
+	interpreter.m_returned = stmt.ret ? evaluate(stmt.ret.get()) : Value{};
 	throw StmtReturn::Return{stmt.token};
 }
 
@@ -415,6 +596,12 @@ void Interpreter::Exec::visit(StmtStruct const& stmt) {
 	// TODO
 }
 
+void Interpreter::Exec::visit(StmtYield const& stmt) {
+	// generator bodies run through Resume
+	if (interpreter.m_reporter) { (*interpreter.m_reporter)(make_internal_error(stmt.token, "yield outside of a generator")); }
+	throw EvalError{};
+}
+
 void Interpreter::Exec::execute(Stmt const& stmt) {
 	if (!interpreter.is_errored()) {
 		try {
@@ -444,6 +631,47 @@ void Interpreter::Exec::execute_block(std::span<UStmt const> stmts) {
 
 Interpreter::Interpreter(std::unique_ptr<util::Notifier> custom) : m_reporter{std::make_unique<util::Reporter>(std::move(custom))} { add_intrinsics(); }
 
+Interpreter::Interpreter(Image const& image, std::unique_ptr<util::Notifier> custom)
+	: media{image.m_media}, cache{image.m_cache}, debug{image.m_debug}, m_reporter{std::make_unique<util::Reporter>(std::move(custom))},
+	  m_frozen{image.m_frozen}, m_environment{image.m_environment.clone()} {
+	m_storage.imported = image.m_imported;
+}
+
+Interpreter::Interpreter(Image&& image, std::unique_ptr<util::Notifier> custom)
+	: media{image.m_media}, cache{image.m_cache}, debug{image.m_debug}, m_reporter{std::make_unique<util::Reporter>(std::move(custom))},
+	  m_frozen{image.m_frozen}, m_environment{std::move(image.m_environment)} {
+	m_storage.imported = image.m_imported;
+}
+
+Interpreter::~Interpreter() {
+	for (auto const& task : m_tasks) { task.state->wait(); }
+}
+
+Interpreter::Image Interpreter::snapshot() {
+	if (!m_storage.texts.empty() || !m_storage.executed.empty()) {
+		auto frozen = std::make_shared<Storage>();
+		frozen->texts = std::move(m_storage.texts);
+		frozen->executed = std::move(m_storage.executed);
+		frozen->arena = std::move(m_storage.arena);
+		m_storage.texts.clear();
+		m_storage.executed.clear();
+		m_storage.arena = util::Arena{};
+		m_frozen.push_back(std::move(frozen));
+	}
+	return image(m_environment.clone());
+}
+
+Interpreter::Image Interpreter::image(Environment environment) const {
+	auto ret = Image{};
+	ret.m_frozen = m_frozen;
+	ret.m_environment = std::move(environment);
+	ret.m_imported = m_storage.imported;
+	ret.m_media = media;
+	ret.m_cache = cache;
+	ret.m_debug = debug;
+	return ret;
+}
+
 bool Interpreter::execute_or_evaluate(Source text) {
 	if (Parser::is_expression(text.text)) { return evaluate(text.text); }
 	return execute(text);
@@ -451,20 +679,90 @@ bool Interpreter::execute_or_evaluate(Source text) {
 
 bool Interpreter::execute(Source program) {
 	if (program.text.empty()) { return true; }
-	program = store(program);
+	auto const ret = execute_stored(store(program));
+	settle();
+	return ret && !is_errored();
+}
+
+bool Interpreter::execute_file(char const* path) { return run_file(path, false); }
+
+bool Interpreter::execute_or_evaluate_file(char const* path) { return run_file(path, true); }
+
+bool Interpreter::run_file(char const* path, bool const evaluate_expression) {
+	auto text = util::TextBuf::map(path, util::TextBuf::eSequential);
+	if (!text) {
+		// no source to point into: mark the path itself
+		auto const str = std::string_view{path};
+		auto const at = Token{.lexeme = str, .location = {.full_text = str, .char_span = {0, str.size()}}, .type = TokenType::eString};
+		m_reporter->notify(make_runtime_error(at, "Failed to read file"));
+		return false;
+	}
+	if (text.view().empty()) { return true; }
+	// read once (it may be a pipe): evaluated from this copy
+	if (evaluate_expression && Parser::is_expression(text.view())) { return evaluate(text.view()); }
+	auto const ret = execute_stored(store(std::move(text), path));
+	settle();
+	return ret && !is_errored();
+}
+
+bool Interpreter::execute_stored(Source program, char const* cache_path) {
+	if (auto module = Module{}; cache_path && module_cache::load(module, cache_path, program)) {
+		for (auto const& path : module.imports) {
+			if (!execute_import(path)) { return false; }
+		}
+		for (auto& stmt : module.stmts) { execute_stmt(std::move(stmt)); }
+		return !is_errored();
+	}
 	auto parser = Parser{program, m_reporter.get()};
+	auto imports = std::vector<Token>{};
 	while (auto stmt = parser.parse_import()) {
 		if (!execute_import(stmt.path)) { return false; }
+		imports.push_back(stmt.path);
 	}
+	auto const first = m_storage.executed.size();
+	while (auto stmt = parser.parse_stmt()) { execute_stmt(std::move(stmt)); }
+	if (is_errored()) { return false; }
+	if (cache_path) { module_cache::save(cache_path, program, imports, std::span{m_storage.executed}.subspan(first)); }
+	return true;
+}
+
+void Interpreter::execute_stmt(UStmt&& stmt) {
+	execute_stmt(*stmt);
+	store(std::move(stmt));
+}
+
+void Interpreter::execute_stmt(Stmt const& stmt) {
 	auto exec = Exec{*this};
-	while (auto stmt = parser.parse_stmt()) {
-		try {
-			exec.execute(*stmt);
-		} catch (StmtBreak::Break const& brk) {
-			m_reporter->notify(make_runtime_error(brk.token, "Unexpected break outside of any loops"));
-		} catch (StmtReturn::Return const& ret) { m_reporter->notify(make_runtime_error(ret.token, "Unexpected return outside of any functions")); }
-		store(std::move(stmt));
+	try {
+		exec.execute(stmt);
+	} catch (StmtBreak::Break const& brk) {
+		m_reporter->notify(make_runtime_error(brk.token, "Unexpected break outside of any loops"));
+	} catch (StmtReturn::Return const& ret) { m_reporter->notify(make_runtime_error(ret.token, "Unexpected return outside of any functions")); }
+}
+
+Interpreter::Program Interpreter::compile(Source source) {
+	if (source.text.empty()) { return {}; }
+	auto storage = std::make_shared<Storage>();
+	if (!source.filename.empty()) { source.filename = storage->arena.copy(source.filename); }
+	source.text = storage->arena.copy(source.text);
+	auto ret = Program{};
+	auto parser = Parser{source, m_reporter.get()};
+	while (auto stmt = parser.parse_import()) { ret.m_imports.push_back(stmt.path); }
+	while (auto stmt = parser.parse_stmt()) { storage->executed.push_back(std::move(stmt)); }
+	if (is_errored()) { return {}; }
+	ret.m_storage = std::move(storage);
+	return ret;
+}
+
+bool Interpreter::execute(Program const& program) {
+	if (!program) { return false; }
+	// functions defined by program refer to its statements: keep them alive as long as this instance
+	if (std::find(m_frozen.begin(), m_frozen.end(), program.m_storage) == m_frozen.end()) { m_frozen.push_back(program.m_storage); }
+	for (auto const& path : program.m_imports) {
+		if (!execute_import(path)) { return false; }
 	}
+	for (auto const& stmt : program.m_storage->executed) { execute_stmt(*stmt); }
+	settle();
 	return !is_errored();
 }
 
@@ -476,28 +774,363 @@ bool Interpreter::evaluate(std::string_view expression) {
 	auto eval = Eval{*this};
 	while (auto expr = parser.parse_expr()) {
 		auto value = expr->accept(eval);
-		std::printf("%s\n", util::unescape(to_string(value)).c_str());
+		auto str = to_string(value);
+		util::append(str, '\n');
+		write(str);
 	}
+	settle();
 	return !is_errored();
 }
 
+Interpreter::Expression Interpreter::compile_expr(std::string_view expression, std::span<std::string_view const> names) {
+	if (expression.empty()) { return {}; }
+	// errors reported by earlier calls are not this parse's: the flag is restored once it's done
+	auto const errored = is_errored();
+	m_reporter->clear_error();
+	auto storage = std::make_shared<Storage>();
+	auto ret = Expression{};
+	for (auto const name : names) { ret.m_names.push_back(storage->arena.copy(name)); }
+	auto parser = Parser{{.text = storage->arena.copy(expression)}, m_reporter.get()};
+	auto expr = parser.parse_expr();
+	if (expr && parser.current().type != TokenType::eEof) {
+		m_reporter->notify(make_diagnostic(parser.current(), "Expected end of expression", TokenType::eEof, Diagnostic::Type::eSyntaxError));
+	} else if (!expr && !is_errored()) {
+		// text that ends mid expression is not diagnosed by the parser (the REPL reads another line instead)
+		m_reporter->notify(make_diagnostic(parser.current(), "Unexpected end of expression", TokenType::eEof, Diagnostic::Type::eSyntaxError));
+	}
+	bool const failed = !expr || is_errored();
+	if (errored) { m_reporter->set_error(); }
+	if (failed) { return {}; }
+	ret.m_storage = std::move(storage);
+	ret.m_expr = std::move(expr);
+	return ret;
+}
+
+Value Interpreter::evaluate(Expression const& expression, std::span<Value const> bindings) {
+	if (!expression) { return {}; }
+	if (bindings.size() != expression.m_names.size()) {
+		m_reporter->notify(make_internal_error({}, "Mismatched binding count"));
+		return {};
+	}
+	// like a call's parameters: visible in this frame only.
+	// The frame is kept for the next call: while the names stay the same, rebinding reuses its page's nodes.
+	if (m_bound.suspended && std::ranges::equal(m_bound.names, expression.m_names)) {
+		m_environment.resume(m_bound.frame);
+	} else {
+		m_bound.names.assign(expression.m_names.begin(), expression.m_names.end());
+		m_environment.push_frame();
+	}
+	for (std::size_t i = 0; i < bindings.size(); ++i) { m_environment.define(m_bound.names[i], bindings[i]); }
+	// an earlier failure (another record's) must not stop this evaluation: statements are skipped while the flag is set.
+	// It's restored once this call is done, and set if this call failed.
+	auto const errored = is_errored();
+	m_reporter->clear_error();
+	auto ret = Value{};
+	try {
+		ret = Eval::evaluate(*this, expression.m_expr.get());
+	} catch (EvalError const&) { m_reporter->set_error(); }
+	m_environment.suspend(m_bound.frame);
+	m_bound.suspended = true;
+	settle();
+	// an intrinsic reports without throwing: its (partial) result is not this call's
+	if (is_errored()) { ret = {}; }
+	if (errored) { m_reporter->set_error(); }
+	return ret;
+}
+
+bool Interpreter::evaluate(Expression const& expression, std::span<batch::Column const> columns, batch::Output& out) {
+	// out's vector keeps its capacity (a host evaluating batch after batch reuses it)
+	out.storage.clear();
+	if (!expression) { return false; }
+	if (columns.size() != expression.m_names.size()) {
+		m_reporter->notify(make_internal_error({}, "Mismatched binding count"));
+		return false;
+	}
+	auto const size = [](batch::Column const& column) { return std::visit([](auto const& span) { return span.size(); }, column); };
+	auto const rows = columns.empty() ? std::size_t{} : size(columns.front());
+	if (std::ranges::any_of(columns, [&](batch::Column const& column) { return size(column) != rows; })) {
+		m_reporter->notify(make_internal_error({}, "Mismatched column sizes"));
+		return false;
+	}
+	if (auto plan = batch::Plan{}; batch::Plan::make(*expression.m_expr, expression.m_names, columns, m_environment, out.storage, plan)) {
+		plan.run(columns, rows, out);
+		return true;
+	}
+	// row by row: the interpreter handles what the kernels don't, and reports errors where they happen
+	out.values = {};
+	out.storage.clear();
+	auto bindings = std::vector<Value>(columns.size());
+	for (std::size_t row = 0; row < rows; ++row) {
+		for (std::size_t i = 0; i < columns.size(); ++i) {
+			auto const visitor = Overloaded{
+				[&](std::span<double const> column) { bindings[i].payload = column[row]; },
+				[&](std::span<std::uint8_t const> column) { bindings[i].payload = Bool{column[row] != 0}; },
+				[&](std::span<std::string_view const> column) { bindings[i].payload = std::string{column[row]}; },
+			};
+			std::visit(visitor, columns[i]);
+		}
+		auto const value = evaluate(expression, bindings);
+		if (row == 0) {
+			if (value.contains<Bool>()) { out.values.emplace<std::vector<std::uint8_t>>(); }
+			if (value.is_string()) { out.values.emplace<std::vector<std::string_view>>(); }
+		}
+		auto const visitor = Overloaded{
+			[&](std::vector<double>& values) {
+				if (!value.contains<double>()) { return false; }
+				values.push_back(value.get<double>());
+				return true;
+			},
+			[&](std::vector<std::uint8_t>& values) {
+				if (!value.contains<Bool>()) { return false; }
+				values.push_back(value.get<Bool>().value ? 1 : 0);
+				return true;
+			},
+			[&](std::vector<std::string_view>& values) {
+				if (!value.is_string()) { return false; }
+				values.push_back(out.storage.emplace_back(value.as_string()));
+				return true;
+			},
+		};
+		if (!std::visit(visitor, out.values)) {
+			// a failed row (reported already) evaluates to null
+			if (!value.is_null()) { m_reporter->notify(make_runtime_error({}, "Batch results must all be numbers, all bools or all strings")); }
+			m_reporter->set_error();
+			return false;
+		}
+	}
+	return true;
+}
+
 void Interpreter::runtime_error(Token const& at, std::string_view message) const { m_reporter->notify(make_runtime_error(at, message)); }
 
+void Interpreter::tick(Token const& at) {
+	// sample the clock only every so often: loops and calls are hot paths
+	static constexpr std::uint32_t interval_v{1024};
+	if (deadline == Clock::time_point::max() || ++m_ticks % interval_v != 0) { return; }
+	if (Clock::now() >= deadline) {
+		m_reporter->notify(make_runtime_error(at, "Timed out"));
+		throw EvalError{};
+	}
+}
+
+Task Interpreter::spawn(Token const& at, Value const& callee, std::span<Value const> args) {
+	return spawn(std::make_shared<Image>(image(m_environment.clone_globals())), at, callee, args);
+}
+
+Task Interpreter::spawn(std::shared_ptr<Image> image, Token const& at, Value const& callee, std::span<Value const> args) {
+	if (!callee.contains<Invocable>() || !callee.get<Invocable>().callback) {
+		runtime_error(at, "Invalid callee");
+		return {};
+	}
+	auto state = std::make_shared<Task::State>();
+	state->image = std::move(image);
+	state->deadline = deadline;
+	state->at = at;
+	state->callee = callee;
+	state->args.assign(args.begin(), args.end());
+	// ownership of arguments is transferred: the task must not share mutable instances with this thread
+	auto detached = std::vector<Value*>{};
+	for (auto& arg : state->args) { detached.push_back(&arg); }
+	if (!detach(std::move(detached))) {
+		runtime_error(at, "Generators, iterators and files cannot be passed to a task");
+		return {};
+	}
+	std::erase_if(m_tasks, [](Task const& task) { return task.state->forwarded.load(); });
+	m_tasks.push_back({state});
+	scheduler::pool().push([state] { run(*state); });
+	return {std::move(state)};
+}
+
+bool Interpreter::for_each(Token const& at, Value const& callee, std::span<Value const> items) {
+	// one image for all the calls
+	auto const image = std::make_shared<Image>(this->image(m_environment.clone_globals()));
+	auto tasks = std::vector<Task>{};
+	tasks.reserve(items.size());
+	for (auto const& item : items) {
+		auto task = spawn(image, at, callee, {&item, 1});
+		if (!task.state) { break; }
+		tasks.push_back(std::move(task));
+	}
+	for (auto const& task : tasks) { join(at, task); }
+	return !is_errored();
+}
+
+Value Interpreter::join(Token const& at, Task const& task) {
+	if (!task.state) {
+		runtime_error(at, "Invalid task");
+		return {};
+	}
+	auto& state = *task.state;
+	state.wait();
+	auto lock = std::scoped_lock{state.mutex};
+	// output / diagnostics go to the first joiner only
+	if (!state.forwarded.exchange(true)) {
+		write(state.output);
+		m_reporter->forward(state.diagnostics);
+		state.output.clear();
+		state.diagnostics.clear();
+	}
+	if (state.failed) {
+		runtime_error(at, "Joined task failed");
+		return {};
+	}
+	// every joiner gets its own copy of the result
+	auto ret = state.result;
+	if (!detach({&ret})) {
+		runtime_error(at, "Generators, iterators and files cannot be returned from a task");
+		return {};
+	}
+	return ret;
+}
+
+Value Interpreter::resume(Token const& at, Generator const& generator) {
+	if (!generator.state) {
+		runtime_error(at, "Invalid generator");
+		return {};
+	}
+	auto& state = *generator.state;
+	if (state.done) { return {}; }
+	if (state.running) {
+		runtime_error(at, "Generator is already running");
+		throw EvalError{};
+	}
+	struct Park {
+		Environment& environment;
+		Generator::State& state;
+		bool finished{true};
+
+		// also runs when unwinding from a runtime error, which ends the generator
+		~Park() {
+			environment.suspend(state.frame);
+			state.running = false;
+			if (finished) {
+				state.done = true;
+				state.steps = {};
+				state.frame = {};
+			}
+		}
+	};
+	state.running = true;
+	m_environment.resume(state.frame);
+	auto park = Park{m_environment, state};
+	auto resume = Resume{*this, state};
+	// an intrinsic reports an error without throwing: stop stepping (a loop would never see it) and end the generator
+	while (!resume.suspended && !state.steps.empty() && !is_errored()) { resume.step(); }
+	park.finished = state.steps.empty() || is_errored();
+	return std::move(resume.out);
+}
+
+void Interpreter::settle() {
+	// tasks spawned but never joined are joined in order of spawning
+	auto tasks = std::exchange(m_tasks, {});
+	for (auto const& task : tasks) {
+		if (!task.state->forwarded) { join(task.state->at, task); }
+	}
+}
+
+void Interpreter::run(Task::State& task) {
+	using Status = Task::State::Status;
+	auto expected = Status::ePending;
+	if (!task.status.compare_exchange_strong(expected, Status::eRunning)) { return; }
+	{
+		// spawn's image is this task's alone (for_each's is shared): it already is a private copy of the globals, take it
+		auto in = task.image.use_count() == 1 ? Interpreter{std::move(*task.image)} : Interpreter{*task.image};
+		in.deadline = task.deadline;
+		in.redirect(&task.output, &task.diagnostics);
+		try {
+			task.result = task.callee.get<Invocable>().callback(in, {task.at, task.args});
+		} catch (EvalError const&) {
+			in.m_reporter->set_error();
+		} catch (StmtBreak::Break const& brk) { in.runtime_error(brk.token, "Unexpected break outside of any loops"); }
+		in.settle();
+		task.failed = in.is_errored();
+	}
+	task.image.reset();
+	task.callee = {};
+	task.args.clear();
+	{
+		auto lock = std::scoped_lock{task.mutex};
+		task.status = Status::eDone;
+	}
+	task.done.notify_all();
+}
+
+void Interpreter::redirect(std::string* output, std::string* diagnostics) {
+	m_output = output;
+	m_reporter->capture = diagnostics;
+}
+
+void Interpreter::write(std::string_view text) const {
+	if (m_output) {
+		util::append(*m_output, text);
+		if (on_output) { on_output(*m_output); }
+	} else {
+		std::fwrite(text.data(), 1, text.size(), stdout);
+	}
+}
+
 void Interpreter::clear_state() {
+	settle();
 	m_environment = Environment{};
+	m_bound = {};
 	m_storage.clear();
-	m_reporter.reset({});
+	m_frozen.clear();
+	m_reporter->clear_error();
+	add_intrinsics();
+}
+
+void Interpreter::reset(Image const& image) {
+	settle();
+	// the suspended binding frame belongs to the environment being replaced (and holds the last request's values)
+	m_bound = {};
+	m_storage.clear();
+	m_storage.imported = image.m_imported;
+	m_frozen = image.m_frozen;
+	m_environment = image.m_environment.clone();
+	m_reporter->clear_error();
+	redirect({}, {});
+	on_output = {};
+	deadline = Clock::time_point::max();
+	media = image.m_media;
+	cache = image.m_cache;
+	debug = image.m_debug;
+}
+
+Interpreter::Stats Interpreter::stats() const {
+	return Stats{
+		.arena = m_storage.arena.stats(),
+		.mapped = m_storage.texts.size(),
+		.statements = m_storage.executed.size(),
+		.values = m_environment.size(),
+	};
 }
 
 bool Interpreter::execute_import(Token const& path) {
 	if (std::find(m_storage.imported.begin(), m_storage.imported.end(), path.lexeme) != m_storage.imported.end()) { return true; }
 	auto str = std::string{path.lexeme};
-	auto program = std::string{};
-	if (!media.read_to(program, str)) {
+	if (auto const text = media.find_embedded(str)) {
+		// embedded text is static: no storage required (an empty module is found all the same)
+		if (!text->empty() && !execute_stored({.filename = path.lexeme, .text = *text})) { return false; }
+		m_storage.imported.push_back(std::move(str));
+		return true;
+	}
+	auto const resolved = media.resolve(str);
+	if (resolved.empty()) {
 		m_reporter->notify(make_runtime_error(path, "File not found"));
 		return false;
 	}
-	if (execute({.filename = path.lexeme, .text = program})) {
+	auto text = util::TextBuf::map(resolved.c_str(), util::TextBuf::eSequential);
+	if (!text) {
+		m_reporter->notify(make_runtime_error(path, "Failed to read file"));
+		return false;
+	}
+	// an empty module is imported (once), like any other
+	if (text.view().empty()) {
+		m_storage.imported.push_back(std::move(str));
+		return true;
+	}
+	auto const cache_path = cache.modules ? module_cache::path_for(resolved, cache.directory) : std::string{};
+	if (execute_stored(store(std::move(text), path.lexeme), cache_path.empty() ? nullptr : cache_path.c_str())) {
 		m_storage.imported.push_back(std::move(str));
 		return true;
 	}
@@ -521,20 +1154,31 @@ void Interpreter::add_intrinsic() {
 
 void Interpreter::add_intrinsics() {
 	using namespace intrinsics;
-	add_intrinsic<Print, PrintF, Clone, Str, Now, File>();
+	add_intrinsic<Print, PrintF, Clone, Str, Num, Len, Substr, Now, File, Spawn, Join, ForEach>();
+	add_intrinsic<Find, RFind, Count, StartsWith, Replace, Split, Trim>();
+	add_intrinsic<MakeChannel, Send, Recv, TryRecv, Close, Next, Done>();
+	add_intrinsic<Range, Iter, Map, Filter, Take, Zip, Reduce, Sort>();
+	add_intrinsic<Memoize, MemoStats>();
+	add_intrinsic<Open, ReadLine, ReadChunk>();
+	add_intrinsic<JsonParse, JsonStringify, Field>();
+	add_intrinsic<Serialize, Deserialize, Save, Load>();
 }
 
 Source Interpreter::store(Source source) {
 	assert(!source.text.empty());
-	if (!source.filename.empty()) {
-		m_storage.texts.push_back(source.filename);
-		source.filename = m_storage.texts.back();
-	}
-	m_storage.texts.push_back(source.text);
-	source.text = m_storage.texts.back();
+	if (!source.filename.empty()) { source.filename = m_storage.arena.copy(source.filename); }
+	source.text = m_storage.arena.copy(source.text);
 	return source;
 }
 
+Source Interpreter::store(util::TextBuf&& text, std::string_view filename) {
+	auto ret = Source{};
+	if (!filename.empty()) { ret.filename = m_storage.arena.copy(filename); }
+	m_storage.texts.push_back(std::move(text));
+	ret.text = m_storage.texts.back();
+	return ret;
+}
+
 Stmt& Interpreter::store(UStmt&& stmt) {
 	assert(stmt);
 	m_storage.executed.push_back(std::move(stmt));
@@ -0,0 +1,48 @@
+#include <toylang/interpreter_pool.hpp>
+#include <utility>
+
+namespace toylang {
+InterpreterPool::Lease InterpreterPool::acquire() {
+	auto lock = std::unique_lock{m_mutex};
+	if (!m_idle.empty()) {
+		auto ret = std::move(m_idle.back());
+		m_idle.pop_back();
+		return Lease{*this, std::move(ret)};
+	}
+	++m_created;
+	lock.unlock();
+	return Lease{*this, std::make_unique<Interpreter>(m_image)};
+}
+
+std::size_t InterpreterPool::idle() const {
+	auto lock = std::scoped_lock{m_mutex};
+	return m_idle.size();
+}
+
+std::size_t InterpreterPool::created() const {
+	auto lock = std::scoped_lock{m_mutex};
+	return m_created;
+}
+
+Interpreter::Stats InterpreterPool::release(std::unique_ptr<Interpreter>&& interpreter) {
+	auto const ret = interpreter->stats();
+	interpreter->reset(m_image);
+	auto lock = std::scoped_lock{m_mutex};
+	m_idle.push_back(std::move(interpreter));
+	return ret;
+}
+
+InterpreterPool::Lease& InterpreterPool::Lease::operator=(Lease&& rhs) noexcept {
+	if (&rhs != this) {
+		release();
+		m_pool = std::exchange(rhs.m_pool, nullptr);
+		m_interpreter = std::move(rhs.m_interpreter);
+	}
+	return *this;
+}
+
+Interpreter::Stats InterpreterPool::Lease::release() {
+	if (!m_pool || !m_interpreter) { return {}; }
+	return std::exchange(m_pool, nullptr)->release(std::move(m_interpreter));
+}
+} // namespace toylang
@@ -1,30 +1,139 @@
 #include <toylang/media.hpp>
 #include <toylang/util.hpp>
 #include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TL_POSIX_STAT
+#include <sys/stat.h>
+#endif
 
 namespace toylang {
 namespace fs = std::filesystem;
 
 namespace {
+struct Stamp {
+	std::uint64_t device{};
+	std::uint64_t inode{};
+	std::uint64_t size{};
+	std::int64_t mtime{};
 
-template <typename T, typename F>
-bool readf(std::span<std::string const> mounted, std::string_view uri, F f) {
-	for (auto const& prefix : mounted) {
-		auto const path = fs::path{prefix} / uri;
-		if (fs::is_regular_file(path)) {
-			f(path);
-			return true;
+	bool operator==(Stamp const&) const = default;
+};
+
+std::size_t make_key(std::span<std::string const> mounted) {
+	auto ret = mounted.size();
+	for (auto const& prefix : mounted) { ret ^= std::hash<std::string>{}(prefix) + 0x9e3779b9 + (ret << 6) + (ret >> 2); }
+	return ret;
+}
+
+std::optional<Stamp> make_stamp(fs::path const& path) {
+#if defined(TL_POSIX_STAT)
+	struct stat st {};
+	if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) { return {}; }
+#if defined(__APPLE__)
+	auto const& mtime = st.st_mtimespec;
+#else
+	auto const& mtime = st.st_mtim;
+#endif
+	return Stamp{
+		.device = static_cast<std::uint64_t>(st.st_dev),
+		.inode = static_cast<std::uint64_t>(st.st_ino),
+		.size = static_cast<std::uint64_t>(st.st_size),
+		.mtime = static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 + static_cast<std::int64_t>(mtime.tv_nsec),
+	};
+#else
+	auto ec = std::error_code{};
+	if (!fs::is_regular_file(path, ec)) { return {}; }
+	auto const size = fs::file_size(path, ec);
+	auto const mtime = fs::last_write_time(path, ec);
+	if (ec) { return {}; }
+	return Stamp{.size = static_cast<std::uint64_t>(size), .mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+#endif
+}
+} // namespace
+
+struct Media::Cache {
+	///
+	/// \brief Cached file contents are bounded to this many bytes in total: past it, entries are dropped to make room
+	///
+	static constexpr std::size_t contents_capacity_v{64 * 1024 * 1024};
+
+	struct Entry {
+		std::string path{};
+		Stamp stamp{};
+		std::size_t mounts{};
+		// index of the mount it was found under (mounted.size(): relative to the working directory)
+		std::size_t rank{};
+	};
+
+	struct Content {
+		Stamp stamp{};
+		std::string text{};
+	};
+
+	std::mutex mutex{};
+	std::unordered_map<std::string, Entry> resolved{};
+	std::unordered_map<std::string, Content> contents{};
+	std::size_t content_bytes{};
+
+	std::optional<Entry> probe(std::span<std::string const> mounted, std::string_view uri) {
+		for (std::size_t i = 0; i < mounted.size(); ++i) {
+			auto path = fs::path{mounted[i]} / uri;
+			if (auto stamp = make_stamp(path)) { return Entry{.path = path.string(), .stamp = *stamp, .rank = i}; }
 		}
+		auto const path = fs::path{uri};
+		if (auto stamp = make_stamp(path)) { return Entry{.path = fs::absolute(path).string(), .stamp = *stamp, .rank = mounted.size()}; }
+		return {};
 	}
-	auto const path = fs::path{uri};
-	if (fs::is_regular_file(path)) {
-		f(path);
-		return true;
+
+	// a file added since under an earlier mount shadows the cached one
+	static bool is_shadowed(std::span<std::string const> mounted, std::string_view uri, Entry const& entry) {
+		auto const earlier = std::min(entry.rank, mounted.size());
+		return std::any_of(mounted.begin(), mounted.begin() + static_cast<std::ptrdiff_t>(earlier),
+						   [uri](std::string const& prefix) { return make_stamp(fs::path{prefix} / uri).has_value(); });
 	}
-	return false;
-}
-} // namespace
+
+	Entry const* resolve(std::span<std::string const> mounted, std::string_view uri) {
+		auto key = std::string{uri};
+		auto const mounts = make_key(mounted);
+		if (auto it = resolved.find(key); it != resolved.end()) {
+			auto const& entry = it->second;
+			if (entry.mounts == mounts && make_stamp(entry.path) == entry.stamp && !is_shadowed(mounted, uri, entry)) { return &entry; }
+			resolved.erase(it);
+		}
+		auto entry = probe(mounted, uri);
+		if (!entry) { return {}; }
+		entry->mounts = mounts;
+		return &resolved.insert_or_assign(std::move(key), std::move(*entry)).first->second;
+	}
+
+	Content const* find_content(std::string const& path, Stamp const& stamp) const {
+		auto const it = contents.find(path);
+		if (it == contents.end() || it->second.stamp != stamp) { return {}; }
+		return &it->second;
+	}
+
+	void store_content(std::string const& path, Stamp const& stamp, std::string const& text) {
+		if (text.size() > contents_capacity_v) { return; }
+		if (auto const it = contents.find(path); it != contents.end()) {
+			content_bytes -= it->second.text.size();
+			contents.erase(it);
+		}
+		while (content_bytes + text.size() > contents_capacity_v && !contents.empty()) {
+			content_bytes -= contents.begin()->second.text.size();
+			contents.erase(contents.begin());
+		}
+		contents.emplace(path, Content{.stamp = stamp, .text = text});
+		content_bytes += text.size();
+	}
+};
+
+Media::Media() : cache{std::make_shared<Cache>()} {}
 
 bool Media::mount(std::string_view path) {
 	auto abs = fs::absolute(path);
@@ -38,11 +147,50 @@ bool Media::mount(std::string_view path) {
 
 bool Media::is_mounted(std::string_view path) const { return std::find(mounted.begin(), mounted.end(), path) != mounted.end(); }
 
-bool Media::exists(std::string_view uri) const {
-	return readf<bool>(mounted, uri, [](fs::path const&) {});
+bool Media::exists(std::string_view uri) const { return find_embedded(uri) || !resolve(uri).empty(); }
+
+std::optional<std::string_view> Media::find_embedded(std::string_view uri) const {
+	for (auto const& file : embedded) {
+		if (file.uri == uri) { return file.text; }
+	}
+	return {};
+}
+
+std::string Media::resolve(std::string_view uri) const {
+	auto lock = std::scoped_lock{cache->mutex};
+	if (auto const* entry = cache->resolve(mounted, uri)) { return entry->path; }
+	return {};
 }
 
 bool Media::read_to(std::string& out, std::string_view uri) const {
-	return readf<std::string>(mounted, uri, [&out](fs::path const& path) { out = util::read_file(path.string().c_str()); });
+	if (auto const text = find_embedded(uri)) {
+		out = *text;
+		return true;
+	}
+	auto lock = std::unique_lock{cache->mutex};
+	auto const* entry = cache->resolve(mounted, uri);
+	if (!entry) { return false; }
+	if (cache_contents) {
+		if (auto const* content = cache->find_content(entry->path, entry->stamp)) {
+			out = content->text;
+			return true;
+		}
+	}
+	// the file is read unlocked: other threads resolve / read meanwhile
+	auto const path = entry->path;
+	auto const stamp = entry->stamp;
+	lock.unlock();
+	out = util::read_file(path.c_str());
+	if (!cache_contents) { return true; }
+	lock.lock();
+	cache->store_content(path, stamp, out);
+	return true;
+}
+
+void Media::clear_cache() const {
+	auto lock = std::scoped_lock{cache->mutex};
+	cache->resolved.clear();
+	cache->contents.clear();
+	cache->content_bytes = 0;
 }
 } // namespace toylang
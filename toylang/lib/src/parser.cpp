@@ -2,6 +2,7 @@
 #include <toylang/util.hpp>
 #include <toylang/util/notifier.hpp>
 #include <toylang/value.hpp>
+#include <charconv>
 
 namespace toylang {
 namespace {
@@ -18,6 +19,12 @@ std::string args_overflow_error_str(std::string kind, std::size_t arity) {
 	util::append(ret, "Too many ", kind, ": ", std::to_string(arity), " (max: ", std::to_string(max_args_v), ")");
 	return ret;
 };
+
+double to_number(std::string_view const lexeme) {
+	auto ret = double{};
+	std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), ret);
+	return ret;
+}
 } // namespace
 
 struct Parser::Scope {
@@ -49,7 +56,7 @@ StmtImport Parser::parse_import() {
 
 UExpr Parser::parse_expr() {
 	try {
-		return equality();
+		return expr_or();
 	} catch (ParseError const&) {}
 	return {};
 }
@@ -58,7 +65,10 @@ UStmt Parser::parse_stmt() {
 	while (!at_end()) {
 		try {
 			return declaration();
-		} catch (ParseError const&) { synchronize(); }
+		} catch (ParseError const&) {
+			m_flags = {};
+			synchronize();
+		}
 	}
 	return {};
 }
@@ -171,7 +181,7 @@ UExpr Parser::primary() {
 	if (advance_if(TokenType::eFalse)) { return std::make_unique<ExprLiteral>(Bool{false}, prev()); }
 	if (advance_if(TokenType::eTrue)) { return std::make_unique<ExprLiteral>(Bool{true}, prev()); }
 	if (advance_if(TokenType::eNull)) { return std::make_unique<ExprLiteral>(nullptr, prev()); }
-	if (advance_if(TokenType::eNumber)) { return std::make_unique<ExprLiteral>(std::atof(std::string{prev().lexeme}.c_str()), prev()); }
+	if (advance_if(TokenType::eNumber)) { return std::make_unique<ExprLiteral>(to_number(prev().lexeme), prev()); }
 	if (advance_if(TokenType::eString)) { return std::make_unique<ExprLiteral>(prev().lexeme, prev()); }
 	if (advance_if(TokenType::eIdentifier)) { return std::make_unique<ExprVar>(prev()); }
 	if (advance_if(TokenType::eParenL)) {
@@ -205,9 +215,12 @@ UPtr<StmtFn> Parser::decl_fn() {
 	consume(TokenType::eParenR);
 	consume(TokenType::eBraceL);
 	if ((m_flags & eScoped) == eScoped) { unwind(TokenType::eEof, "fn only permitted in global scope", name); }
+	m_flags |= eInFn;
 	auto block = make_block();
+	bool const generator = (m_flags & eYielded) == eYielded;
+	m_flags &= ~(eInFn | eYielded);
 	if (arity >= max_args_v) { unwind(TokenType::eParenR, args_overflow_error_str("parameters", arity)); }
-	return std::make_unique<StmtFn>(name, std::move(params), std::move(block));
+	return std::make_unique<StmtFn>(name, std::move(params), std::move(block), generator);
 }
 
 UPtr<StmtVar> Parser::decl_var() {
@@ -250,6 +263,7 @@ UStmt Parser::statement() {
 	if (advance_if(TokenType::eBraceL)) { return stmt_block(); }
 	if (advance_if(TokenType::eBreak)) { return stmt_break(); }
 	if (advance_if(TokenType::eReturn)) { return stmt_return(); }
+	if (advance_if(TokenType::eYield)) { return stmt_yield(); }
 	return stmt_expr();
 }
 
@@ -309,6 +323,16 @@ UPtr<StmtReturn> Parser::stmt_return() {
 	return std::make_unique<StmtReturn>(StmtReturn::Return{token}, std::move(ret));
 }
 
+UPtr<StmtYield> Parser::stmt_yield() {
+	auto token = prev();
+	if ((m_flags & eInFn) != eInFn) { unwind(TokenType::eEof, "yield only permitted in functions", token); }
+	m_flags |= eYielded;
+	auto value = UExpr{};
+	if (!check(TokenType::eSemicolon)) { value = expression(); }
+	consume(TokenType::eSemicolon);
+	return std::make_unique<StmtYield>(token, std::move(value));
+}
+
 UPtr<StmtIf> Parser::stmt_if() {
 	consume(TokenType::eParenL);
 	auto condition = expression();
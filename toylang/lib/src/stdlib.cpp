@@ -0,0 +1,31 @@
+#include <embedded_stdlib.hpp>
+#include <toylang/scanner.hpp>
+#include <toylang/stdlib.hpp>
+
+namespace toylang {
+namespace {
+struct CountErrors {
+	std::size_t errors{};
+
+	constexpr void operator()(Diagnostic const&) { ++errors; }
+};
+
+constexpr bool scans(std::string_view const text) {
+	auto errors = CountErrors{};
+	auto scanner = Scanner<CountErrors>{{.text = text}, &errors};
+	while (scanner.next_token()) {}
+	return errors.errors == 0;
+}
+
+constexpr bool all_scan() {
+	for (auto const& file : embedded::files_v) {
+		if (!scans(file.text)) { return false; }
+	}
+	return true;
+}
+
+static_assert(all_scan(), "Embedded stdlib has lexical errors");
+} // namespace
+
+std::span<Media::Embedded const> stdlib::files() { return embedded::files_v; }
+} // namespace toylang
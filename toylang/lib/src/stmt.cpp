@@ -10,4 +10,5 @@ void StmtBreak::accept(Visitor& out) const { out.visit(*this); }
 void StmtFn::accept(Visitor& out) const { out.visit(*this); }
 void StmtReturn::accept(Visitor& out) const { out.visit(*this); }
 void StmtStruct::accept(Visitor& out) const { out.visit(*this); }
+void StmtYield::accept(Visitor& out) const { out.visit(*this); }
 } // namespace toylang
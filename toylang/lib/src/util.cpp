@@ -1,24 +1,87 @@
 #include <toylang/util.hpp>
 #include <toylang/value.hpp>
+#include <bit>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#define TL_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace toylang {
+namespace {
+int hex_digit(char const c) {
+	if (c >= '0' && c <= '9') { return c - '0'; }
+	if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+	if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+	return -1;
+}
+
+// writes the character for the escape sequence at in[0] == '\\' to out, returns the sequence's length
+std::size_t unescape_one(char*& out, std::string_view const in) {
+	if (in.size() < 2) {
+		// trailing backslash
+		*out++ = '\\';
+		return 1;
+	}
+	switch (in[1]) {
+	case 'n': *out++ = '\n'; return 2;
+	case 't': *out++ = '\t'; return 2;
+	case 'r': *out++ = '\r'; return 2;
+	case '0': *out++ = '\0'; return 2;
+	case '"': *out++ = '"'; return 2;
+	case '\\': *out++ = '\\'; return 2;
+	case 'x': {
+		auto const hi = in.size() > 3 ? hex_digit(in[2]) : -1;
+		auto const lo = in.size() > 3 ? hex_digit(in[3]) : -1;
+		if (hi < 0 || lo < 0) { break; }
+		*out++ = static_cast<char>(hi * 16 + lo);
+		return 4;
+	}
+	default: break;
+	}
+	// unknown (or malformed) escape: kept as is
+	*out++ = in[0];
+	*out++ = in[1];
+	return 2;
+}
+} // namespace
+
 std::string util::unescape(std::string_view in) {
-	auto ret = std::string{};
-	ret.reserve(in.size());
-	for (std::size_t i = 0; i < in.size(); ++i) {
-		if (in[i] == '\\' && i + 1 < in.size()) {
-			switch (in[i + 1]) {
-			case 'n': append(ret, '\n'); break;
-			case 't': append(ret, '\t'); break;
-			default: break;
-			}
-			++i;
+	// every escape sequence is at least as long as what it becomes: the result never outgrows the input
+	auto ret = std::string(in.size(), '\0');
+	auto* out = ret.data();
+#if defined(TL_SSE2)
+	// runs without a backslash are copied a block at a time; escapes are handled only where the mask has a bit set
+	auto const backslash = _mm_set1_epi8('\\');
+	while (in.size() >= 16) {
+		auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in.data()));
+		// out never runs ahead of in: storing the whole block stays inside ret
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), block);
+		auto const mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, backslash)));
+		if (mask == 0) {
+			out += 16;
+			in.remove_prefix(16);
 			continue;
 		}
-		append(ret, in[i]);
+		auto const run = static_cast<std::size_t>(std::countr_zero(mask));
+		out += run;
+		in.remove_prefix(run);
+		in.remove_prefix(unescape_one(out, in));
+	}
+#endif
+	while (!in.empty()) {
+		auto const* next = static_cast<char const*>(std::memchr(in.data(), '\\', in.size()));
+		auto const run = next ? static_cast<std::size_t>(next - in.data()) : in.size();
+		std::memcpy(out, in.data(), run);
+		out += run;
+		in.remove_prefix(run);
+		if (next) { in.remove_prefix(unescape_one(out, in)); }
 	}
+	ret.resize(static_cast<std::size_t>(out - ret.data()));
 	return ret;
 }
 
@@ -47,7 +110,7 @@ std::string util::read_file(char const* path) {
 }
 
 bool util::write_file(char const* path, std::string_view text) {
-	auto file = std::ofstream(path);
+	auto file = std::ofstream(path, std::ios::binary);
 	if (!file) { return false; }
 	file.write(text.data(), static_cast<std::streamsize>(text.size()));
 	return true;
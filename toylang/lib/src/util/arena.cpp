@@ -0,0 +1,37 @@
+#include <toylang/util/arena.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace toylang::util {
+void* Arena::allocate(std::size_t const size, std::size_t const align) {
+	for (; m_index < m_chunks.size(); ++m_index, m_offset = 0) {
+		auto& chunk = m_chunks[m_index];
+		auto const base = reinterpret_cast<std::uintptr_t>(chunk.data.get());
+		auto const first = (base + m_offset + align - 1) / align * align - base;
+		if (first + size <= chunk.size) {
+			m_offset = first + size;
+			++m_stats.allocations;
+			m_stats.bytes += size;
+			return chunk.data.get() + first;
+		}
+	}
+	auto const chunk_size = std::max(m_chunk_size, size + align);
+	m_chunks.push_back(Chunk{std::make_unique_for_overwrite<std::byte[]>(chunk_size), chunk_size});
+	m_stats.reserved += chunk_size;
+	m_offset = 0;
+	return allocate(size, align);
+}
+
+std::string_view Arena::copy(std::string_view const str) {
+	if (str.empty()) { return {}; }
+	auto* ret = static_cast<char*>(allocate(str.size(), alignof(char)));
+	std::memcpy(ret, str.data(), str.size());
+	return {ret, str.size()};
+}
+
+void Arena::reset() {
+	m_index = 0;
+	m_offset = 0;
+	m_stats = {.reserved = m_stats.reserved};
+}
+} // namespace toylang::util
@@ -20,7 +20,7 @@ Value ExprStr::visit(ExprLiteral const& expr) {
 	case Literal::Type::eNull: util::append(out, "null"); break;
 	case Literal::Type::eBool: util::append(out, expr.value.as_bool() ? "true" : "false"); break;
 	case Literal::Type::eString: util::append(out, expr.value.as_string()); break;
-	case Literal::Type::eDouble: util::append(out, std::to_string(expr.value.as_double())); break;
+	case Literal::Type::eDouble: append_to(out, Value{.payload = expr.value.as_double()}); break;
 	}
 	return {};
 }
@@ -0,0 +1,93 @@
+#include <toylang/util/file_reader.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace toylang::util {
+FileReader::FileReader(char const* path, std::size_t buffer_size) : m_file(std::fopen(path, "rb")) {
+	if (!m_file) { return; }
+	// the buffer here replaces stdio's
+	std::setvbuf(m_file, nullptr, _IONBF, 0);
+	m_capacity = std::max(buffer_size, std::size_t{64});
+	m_buffer = std::make_shared<std::string>(m_capacity, '\0');
+}
+
+FileReader::FileReader(FileReader&& rhs) noexcept
+	: m_file(std::exchange(rhs.m_file, nullptr)), m_buffer(std::move(rhs.m_buffer)), m_capacity(std::exchange(rhs.m_capacity, 0)),
+	  m_begin(std::exchange(rhs.m_begin, 0)), m_end(std::exchange(rhs.m_end, 0)), m_eof(std::exchange(rhs.m_eof, false)) {}
+
+FileReader& FileReader::operator=(FileReader&& rhs) noexcept {
+	if (&rhs != this) {
+		close();
+		m_file = std::exchange(rhs.m_file, nullptr);
+		m_buffer = std::move(rhs.m_buffer);
+		m_capacity = std::exchange(rhs.m_capacity, 0);
+		m_begin = std::exchange(rhs.m_begin, 0);
+		m_end = std::exchange(rhs.m_end, 0);
+		m_eof = std::exchange(rhs.m_eof, false);
+	}
+	return *this;
+}
+
+bool FileReader::read_line(std::string_view& out) {
+	if (!m_file) { return false; }
+	std::size_t scanned{};
+	while (true) {
+		auto const* begin = m_buffer->data() + m_begin;
+		auto const* first = begin + scanned;
+		if (auto const* nl = static_cast<char const*>(std::memchr(first, '\n', m_end - m_begin - scanned))) {
+			auto length = static_cast<std::size_t>(nl - begin);
+			m_begin += length + 1;
+			if (length > 0 && begin[length - 1] == '\r') { --length; }
+			out = {begin, length};
+			return true;
+		}
+		scanned = m_end - m_begin;
+		if (m_eof) {
+			if (scanned == 0) { return false; }
+			// last line without a terminator
+			out = {begin, scanned};
+			m_begin = m_end;
+			return true;
+		}
+		if (!fill()) { return false; }
+	}
+}
+
+bool FileReader::read_chunk(std::string_view& out, std::size_t max) {
+	if (!m_file || max == 0) { return false; }
+	if (m_begin == m_end && !m_eof && !fill()) { return false; }
+	if (m_begin == m_end) { return false; }
+	auto const size = std::min(max, m_end - m_begin);
+	out = {m_buffer->data() + m_begin, size};
+	m_begin += size;
+	return true;
+}
+
+void FileReader::close() noexcept {
+	if (m_file) { std::fclose(m_file); }
+	m_file = {};
+	m_buffer.reset();
+	m_capacity = m_begin = m_end = 0;
+	m_eof = false;
+}
+
+bool FileReader::fill() {
+	// unread bytes move to the front; a full buffer (one very long line) doubles.
+	// While views into the buffer are held elsewhere it's left untouched: unread bytes are copied into a new one instead.
+	if (m_buffer.use_count() > 1 || m_end - m_begin == m_capacity) {
+		if (m_end - m_begin == m_capacity) { m_capacity *= 2; }
+		auto fresh = std::make_shared<std::string>(m_capacity, '\0');
+		std::memcpy(fresh->data(), m_buffer->data() + m_begin, m_end - m_begin);
+		m_buffer = std::move(fresh);
+	} else if (m_begin > 0) {
+		std::memmove(m_buffer->data(), m_buffer->data() + m_begin, m_end - m_begin);
+	}
+	m_end -= m_begin;
+	m_begin = 0;
+	auto const read = std::fread(m_buffer->data() + m_end, 1, m_capacity - m_end, m_file);
+	m_end += read;
+	if (read == 0) { m_eof = true; }
+	return true;
+}
+} // namespace toylang::util
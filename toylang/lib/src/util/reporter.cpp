@@ -83,6 +83,18 @@ void Reporter::on_notify(Diagnostic const& diag) {
 		fptr = stderr;
 	}
 	auto const ctx = make_data(diag.token);
+	if (capture) {
+		util::append(*capture, format(ctx, diag, quote, mark), '\n');
+		return;
+	}
 	std::fprintf(fptr, "%s\n", format(ctx, diag, quote, mark).c_str());
 }
+
+void Reporter::forward(std::string_view const formatted) {
+	if (capture) {
+		util::append(*capture, formatted);
+		return;
+	}
+	std::fwrite(formatted.data(), 1, formatted.size(), stderr);
+}
 } // namespace toylang::util
@@ -0,0 +1,111 @@
+#include <toylang/util/str_search.hpp>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace toylang::util {
+namespace {
+constexpr std::size_t block_v{16};
+
+bool is_space(char const c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+// the middle of the needle at candidate (first and last bytes already match)
+bool matches(char const* candidate, std::string_view needle) {
+	return needle.size() <= 2 || std::memcmp(candidate + 1, needle.data() + 1, needle.size() - 2) == 0;
+}
+
+#if defined(TL_SSE2)
+// bit i set: haystack[i] == needle.front() && haystack[i + n - 1] == needle.back()
+std::uint32_t candidates(char const* at, __m128i const first, __m128i const last, std::size_t const n) {
+	auto const lhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(at));
+	auto const rhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(at + n - 1));
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(lhs, first), _mm_cmpeq_epi8(rhs, last))));
+}
+#endif
+} // namespace
+
+std::size_t find(std::string_view const haystack, std::string_view const needle, std::size_t from) {
+	auto const n = needle.size();
+	if (from > haystack.size() || n > haystack.size() - from) { return npos_v; }
+	if (n == 0) { return from; }
+	auto const* data = haystack.data();
+	if (n == 1) {
+		auto const* ret = static_cast<char const*>(std::memchr(data + from, needle.front(), haystack.size() - from));
+		return ret ? static_cast<std::size_t>(ret - data) : npos_v;
+	}
+	// candidate positions are [from, last]
+	auto const last = haystack.size() - n;
+#if defined(TL_SSE2)
+	auto const first_v = _mm_set1_epi8(needle.front());
+	auto const last_v = _mm_set1_epi8(needle.back());
+	for (; from + block_v <= last + 1; from += block_v) {
+		for (auto mask = candidates(data + from, first_v, last_v, n); mask != 0; mask &= mask - 1) {
+			auto const i = from + static_cast<std::size_t>(std::countr_zero(mask));
+			if (matches(data + i, needle)) { return i; }
+		}
+	}
+#endif
+	for (; from <= last; ++from) {
+		if (data[from] == needle.front() && data[from + n - 1] == needle.back() && matches(data + from, needle)) { return from; }
+	}
+	return npos_v;
+}
+
+std::size_t rfind(std::string_view const haystack, std::string_view const needle) {
+	auto const n = needle.size();
+	if (n > haystack.size()) { return npos_v; }
+	if (n == 0) { return haystack.size(); }
+	auto const* data = haystack.data();
+	// one past the last candidate position still to check
+	auto end = haystack.size() - n + 1;
+#if defined(TL_SSE2)
+	auto const first_v = _mm_set1_epi8(needle.front());
+	auto const last_v = _mm_set1_epi8(needle.back());
+	for (; end >= block_v; end -= block_v) {
+		for (auto mask = candidates(data + end - block_v, first_v, last_v, n); mask != 0;) {
+			auto const bit = 31 - std::countl_zero(mask);
+			auto const i = end - block_v + static_cast<std::size_t>(bit);
+			if (matches(data + i, needle)) { return i; }
+			mask &= ~(std::uint32_t{1} << bit);
+		}
+	}
+#endif
+	while (end-- > 0) {
+		if (data[end] == needle.front() && data[end + n - 1] == needle.back() && matches(data + end, needle)) { return end; }
+	}
+	return npos_v;
+}
+
+std::size_t count(std::string_view const haystack, std::string_view const needle) {
+	if (needle.empty()) { return 0; }
+	auto ret = std::size_t{};
+	for (auto i = find(haystack, needle); i != npos_v; i = find(haystack, needle, i + needle.size())) { ++ret; }
+	return ret;
+}
+
+std::string replace(std::string_view const haystack, std::string_view const from, std::string_view const to) {
+	if (from.empty()) { return std::string{haystack}; }
+	auto ret = std::string{};
+	// enough when to is no longer than from, a lower bound otherwise
+	ret.reserve(haystack.size());
+	auto begin = std::size_t{};
+	for (auto i = find(haystack, from); i != npos_v; i = find(haystack, from, begin)) {
+		ret.append(haystack.substr(begin, i - begin));
+		ret.append(to);
+		begin = i + from.size();
+	}
+	ret.append(haystack.substr(begin));
+	return ret;
+}
+
+std::string_view trim(std::string_view str) {
+	while (!str.empty() && is_space(str.front())) { str.remove_prefix(1); }
+	while (!str.empty() && is_space(str.back())) { str.remove_suffix(1); }
+	return str;
+}
+} // namespace toylang::util
@@ -0,0 +1,97 @@
+#include <toylang/util.hpp>
+#include <toylang/util/text_buf.hpp>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TL_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace toylang::util {
+#if defined(TL_MMAP)
+namespace {
+bool read_fd(int const fd, std::string& out) {
+	char chunk[64 * 1024];
+	while (true) {
+		auto const ret = ::read(fd, chunk, sizeof(chunk));
+		if (ret == 0) { return true; }
+		if (ret < 0) {
+			if (errno == EINTR) { continue; }
+			return false;
+		}
+		out.append(chunk, static_cast<std::size_t>(ret));
+	}
+}
+} // namespace
+#endif
+
+TextBuf TextBuf::map(char const* path, [[maybe_unused]] Hints hints) {
+	auto ret = TextBuf{};
+#if defined(TL_MMAP)
+	int const fd = ::open(path, O_RDONLY);
+	if (fd < 0) { return ret; }
+	struct stat st {};
+	if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		auto const size = static_cast<std::size_t>(st.st_size);
+		if (void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED) {
+			if ((hints & eSequential) == eSequential) { ::madvise(data, size, MADV_SEQUENTIAL); }
+			ret.m_mapped = data;
+			ret.m_size = size;
+			ret.m_valid = true;
+		}
+	}
+	// not mappable (pipes, character devices, files whose size is not known up front, ...): read it
+	if (auto text = std::string{}; !ret.m_valid && read_fd(fd, text)) {
+		ret.m_owned = CharBuf{text};
+		ret.m_valid = true;
+	}
+	::close(fd);
+#else
+	if (auto file = std::ifstream(path, std::ios::binary)) {
+		ret.m_owned = CharBuf{std::string(std::istreambuf_iterator<char>{file}, {})};
+		ret.m_valid = !file.bad();
+	}
+#endif
+	return ret;
+}
+
+TextBuf::TextBuf(std::string_view text) : m_owned{text}, m_valid{true} {}
+
+TextBuf::TextBuf(TextBuf&& rhs) noexcept
+	: m_owned{std::move(rhs.m_owned)}, m_mapped{std::exchange(rhs.m_mapped, nullptr)}, m_size{std::exchange(rhs.m_size, 0)},
+	  m_valid{std::exchange(rhs.m_valid, false)} {}
+
+TextBuf& TextBuf::operator=(TextBuf&& rhs) noexcept {
+	if (&rhs != this) {
+		release();
+		m_owned = std::move(rhs.m_owned);
+		m_mapped = std::exchange(rhs.m_mapped, nullptr);
+		m_size = std::exchange(rhs.m_size, 0);
+		m_valid = std::exchange(rhs.m_valid, false);
+	}
+	return *this;
+}
+
+TextBuf::~TextBuf() noexcept { release(); }
+
+std::string_view TextBuf::view() const {
+	if (m_mapped) { return {static_cast<char const*>(m_mapped), m_size}; }
+	return m_owned.view();
+}
+
+void TextBuf::release() noexcept {
+#if defined(TL_MMAP)
+	if (m_mapped) { ::munmap(m_mapped, m_size); }
+#endif
+	m_mapped = {};
+	m_size = {};
+}
+} // namespace toylang::util
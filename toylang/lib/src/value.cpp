@@ -1,14 +1,26 @@
 #include <toylang/util.hpp>
 #include <toylang/value.hpp>
 #include <cassert>
+#include <charconv>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
 
 namespace toylang {
 namespace {
-std::string from(double d) {
-	auto const i = static_cast<std::int64_t>(d);
-	if (static_cast<double>(i) == d) { return std::to_string(i); }
-	return std::to_string(d);
+void append_number(std::string& out, double d) {
+	// shortest round-trip representation, integral values without exponent
+	static constexpr auto int_max_v = static_cast<double>(std::int64_t{1} << 53);
+	char buf[32];
+	auto const [ptr, ec] = (d < int_max_v && d > -int_max_v && d == static_cast<double>(static_cast<std::int64_t>(d)))
+							   ? std::to_chars(std::begin(buf), std::end(buf), static_cast<std::int64_t>(d))
+							   : std::to_chars(std::begin(buf), std::end(buf), d);
+	if (ec != std::errc{}) { return; }
+	out.append(buf, ptr);
 }
+
+// slices using less than 1 / waste_ratio_v of their buffer are copied when stored
+constexpr std::size_t waste_ratio_v{4};
 } // namespace
 
 StructInst StructDef::instance() const {
@@ -18,6 +30,23 @@ StructInst StructDef::instance() const {
 	return ret;
 }
 
+StructInst::Fields::~Fields() {
+	// instances only referenced from here are taken apart one at a time: each is destroyed after its own instances were moved out
+	auto pending = std::vector<std::shared_ptr<Fields>>{};
+	auto const take = [&pending](Fields& fields) {
+		for (auto& [_, value] : fields) {
+			auto* inst = std::get_if<StructInst>(&value.payload);
+			if (inst && inst->fields && inst->fields.use_count() == 1) { pending.push_back(std::move(inst->fields)); }
+		}
+	};
+	take(*this);
+	while (!pending.empty()) {
+		auto fields = std::move(pending.back());
+		pending.pop_back();
+		take(*fields);
+	}
+}
+
 Value const* StructInst::find(std::string_view name) const {
 	if (!fields) { return {}; }
 	if (auto const it = fields->find(name); it != fields->end()) { return &it->second; }
@@ -28,6 +57,8 @@ bool StructInst::set(std::string_view name, Value&& value) {
 	if (!fields) { return false; }
 	auto const it = fields->find(name);
 	if (it == fields->end()) { return false; }
+	// fields outlive the expression that produced value (eg a List of file lines)
+	compact(value);
 	it->second = std::move(value);
 	return true;
 }
@@ -44,6 +75,19 @@ Value Value::make(Literal const& literal) {
 	return ret;
 }
 
+Value Value::make_slice(std::shared_ptr<std::string const> const& buffer, std::string_view view) {
+	if (view.size() <= small_string_v || !buffer) { return {.payload = std::string{view}}; }
+	auto const offset = static_cast<std::size_t>(view.data() - buffer->data());
+	assert(offset + view.size() <= buffer->size());
+	return {.payload = StrSlice{.buffer = buffer, .offset = offset, .length = view.size()}};
+}
+
+std::string_view Value::as_string() const {
+	if (auto const* str = std::get_if<std::string>(&payload)) { return *str; }
+	if (auto const* slice = std::get_if<StrSlice>(&payload)) { return slice->view(); }
+	return {};
+}
+
 bool Value::is_truthy() const {
 	static constexpr auto visitor = Overloaded{
 		[](std::nullptr_t) { return false; },
@@ -56,34 +100,44 @@ bool Value::is_truthy() const {
 std::string Value::to_string() const { return toylang::to_string(*this); }
 
 std::string to_string(Value const& value) {
+	auto ret = std::string{};
+	append_to(ret, value);
+	return ret;
+}
+
+void append_to(std::string& out, Value const& value) {
 	auto const visitor = Overloaded{
-		[](std::nullptr_t) { return std::string{"null"}; },
-		[](Bool const b) { return b ? std::string{"true"} : std::string{"false"}; },
-		[](double const d) { return from(d); },
-		[](std::string const& s) { return s; },
-		[](Invocable const& i) { return std::string{"<fn " + std::string{i.def.lexeme} + ">"}; },
-		[](StructDef const& s) { return std::string{s.name}; },
-		[](StructInst const& s) { return std::string{s.def.name} + " instance"; },
+		[&out](std::nullptr_t) { util::append(out, "null"); },
+		[&out](Bool const b) { util::append(out, b ? "true" : "false"); },
+		[&out](double const d) { append_number(out, d); },
+		[&out](std::string const& s) { util::append(out, s); },
+		[&out](StrSlice const& s) { util::append(out, s.view()); },
+		[&out](Invocable const& i) { util::append(out, "<fn ", i.def.lexeme, ">"); },
+		[&out](StructDef const& s) { util::append(out, s.name); },
+		[&out](StructInst const& s) { util::append(out, s.def.name, " instance"); },
+		[&out](Task const&) { util::append(out, "<task>"); },
+		[&out](Channel const&) { util::append(out, "<channel>"); },
+		[&out](Generator const&) { util::append(out, "<generator>"); },
+		[&out](Iterator const&) { util::append(out, "<iterator>"); },
+		[&out](FileHandle const&) { util::append(out, "<file>"); },
 	};
-	return value.visit(visitor);
+	value.visit(visitor);
 }
 
 bool Value::operator==(Value const& rhs) const {
 	auto const visitor = Overloaded{
 		[&rhs](std::nullptr_t) { return rhs.is_null(); },
 		[&rhs](Bool const b) {
-			if (rhs.contains<std::string>()) { return false; }
+			if (rhs.is_string()) { return false; }
 			return b.value == rhs.is_truthy();
 		},
 		[&rhs](double const ld) {
 			if (auto rd = std::get_if<double>(&rhs.payload)) { return ld == *rd; }
-			if (rhs.contains<std::string>()) { return false; }
+			if (rhs.is_string()) { return false; }
 			return rhs.is_truthy();
 		},
-		[&rhs](std::string const& ls) {
-			if (auto const& rs = std::get_if<std::string>(&rhs.payload)) { return ls == *rs; }
-			return false;
-		},
+		[&rhs](std::string const& ls) { return rhs.is_string() && ls == rhs.as_string(); },
+		[&rhs](StrSlice const& ls) { return rhs.is_string() && ls.view() == rhs.as_string(); },
 		[&rhs](Invocable const& li) {
 			if (auto const& ri = std::get_if<Invocable>(&rhs.payload)) { return li.def.lexeme == ri->def.lexeme; }
 			return false;
@@ -96,7 +150,84 @@ bool Value::operator==(Value const& rhs) const {
 			if (auto const& ri = std::get_if<StructInst>(&rhs.payload)) { return li.def.name == ri->def.name && li.fields.get() == ri->fields.get(); }
 			return false;
 		},
+		[&rhs](Task const& lt) {
+			if (auto const& rt = std::get_if<Task>(&rhs.payload)) { return lt.state == rt->state; }
+			return false;
+		},
+		[&rhs](Channel const& lc) {
+			if (auto const& rc = std::get_if<Channel>(&rhs.payload)) { return lc.state == rc->state; }
+			return false;
+		},
+		[&rhs](Generator const& lg) {
+			if (auto const& rg = std::get_if<Generator>(&rhs.payload)) { return lg.state == rg->state; }
+			return false;
+		},
+		[&rhs](Iterator const& li) {
+			if (auto const& ri = std::get_if<Iterator>(&rhs.payload)) { return li.state == ri->state; }
+			return false;
+		},
+		[&rhs](FileHandle const& lf) {
+			if (auto const& rf = std::get_if<FileHandle>(&rhs.payload)) { return lf.state == rf->state; }
+			return false;
+		},
+	};
+	return visit(visitor);
+}
+
+std::size_t Value::hash() const {
+	auto const combine = [](std::size_t const type, std::size_t const h) { return h ^ (type * 0x9e3779b97f4a7c15); };
+	auto const pointer = [&](void const* ptr) { return combine(payload.index(), std::hash<void const*>{}(ptr)); };
+	auto const visitor = Overloaded{
+		[&](std::nullptr_t) { return combine(payload.index(), 0); },
+		[&](Bool const b) { return combine(payload.index(), b.value ? 1 : 0); },
+		// -0.0 == 0.0
+		[&](double const d) { return combine(payload.index(), d == 0.0 ? 0 : std::hash<double>{}(d)); },
+		[](std::string const& str) { return std::hash<std::string_view>{}(str); },
+		[](StrSlice const& str) { return std::hash<std::string_view>{}(str.view()); },
+		[&](Invocable const& inv) { return combine(payload.index(), std::hash<std::string_view>{}(inv.def.lexeme)); },
+		[&](StructDef const& def) { return combine(payload.index(), std::hash<std::string_view>{}(def.name)); },
+		[&](StructInst const& inst) { return pointer(inst.fields.get()); },
+		[&](Task const& task) { return pointer(task.state.get()); },
+		[&](Channel const& channel) { return pointer(channel.state.get()); },
+		[&](Generator const& gen) { return pointer(gen.state.get()); },
+		[&](Iterator const& it) { return pointer(it.state.get()); },
+		[&](FileHandle const& file) { return pointer(file.state.get()); },
 	};
 	return visit(visitor);
 }
+
+void compact(Value& value) {
+	auto* slice = std::get_if<StrSlice>(&value.payload);
+	if (!slice || slice->length * waste_ratio_v >= slice->buffer->size()) { return; }
+	value.payload = std::string{slice->view()};
+}
+
+bool detach(std::vector<Value*> pending) {
+	using Fields = StructInst::Fields;
+	auto copies = std::unordered_map<Fields const*, std::shared_ptr<Fields>>{};
+	auto ret = true;
+	// their state is not thread safe: another task must not reach it
+	auto const invalidate = Overloaded{
+		[&](Generator& gen) { ret &= !std::exchange(gen.state, {}); },
+		[&](Iterator& it) { ret &= !std::exchange(it.state, {}); },
+		[&](FileHandle& file) { ret &= !std::exchange(file.state, {}); },
+		[](auto&) {},
+	};
+	while (!pending.empty()) {
+		compact(*pending.back());
+		std::visit(invalidate, pending.back()->payload);
+		auto* inst = std::get_if<StructInst>(&pending.back()->payload);
+		pending.pop_back();
+		if (!inst || !inst->fields) { continue; }
+		if (auto it = copies.find(inst->fields.get()); it != copies.end()) {
+			inst->fields = it->second;
+			continue;
+		}
+		auto copy = std::make_shared<Fields>(*inst->fields);
+		copies.emplace(inst->fields.get(), copy);
+		inst->fields = std::move(copy);
+		for (auto& [_, field] : *inst->fields) { pending.push_back(&field); }
+	}
+	return ret;
+}
 } // namespace toylang
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <span>
 #include <string_view>
 
@@ -6,36 +7,48 @@ namespace toylang {
 struct CmdArgs {
 	struct Option {
 		std::string_view key{};
+		std::string_view value{};
 
 		explicit constexpr operator bool() const { return !key.empty(); }
 	};
 
 	static constexpr std::size_t max_options_v{8};
+	// options that consume a value: --key=value or --key value
+	static constexpr std::string_view valued_v[] = {"jobs", "j", "serve", "timeout"};
 
 	Option options[max_options_v]{};
 	std::span<char const* const> args{};
 
-	static constexpr bool is_option(std::string_view const arg) { return arg[0] == '-'; }
+	static constexpr bool is_option(std::string_view const arg) { return !arg.empty() && arg[0] == '-'; }
+	static constexpr bool is_valued(std::string_view const key) { return std::find(std::begin(valued_v), std::end(valued_v), key) != std::end(valued_v); }
 
 	constexpr CmdArgs(int argc, char const* const* argv) {
 		int index{1};
+		std::size_t option{};
 		for (; index < argc; ++index) {
 			auto const arg = std::string_view{argv[index]};
-			if (arg[0] == '-') {
-				index = add_options(index, arg.substr(1));
-			} else {
-				break;
-			}
+			if (!is_option(arg)) { break; }
+			auto const first = option;
+			option = add_options(option, arg.substr(1));
+			if (option == first) { continue; }
+			auto& last = options[option - 1];
+			if (is_valued(last.key) && last.value.empty() && index + 1 < argc) { last.value = argv[++index]; }
 		}
-		args = {argv + index, static_cast<std::size_t>(argc - 1)};
+		args = {argv + index, static_cast<std::size_t>(argc - index)};
 	}
 
-	constexpr int add_options(int index, std::string_view arg) {
+	constexpr std::size_t add_options(std::size_t index, std::string_view arg) {
 		if (arg.empty()) { return index; }
 		if (arg[0] == '-') {
-			options[index++] = {arg.substr(1)};
+			arg = arg.substr(1);
+			auto const eq = arg.find('=');
+			auto option = Option{arg.substr(0, eq)};
+			if (eq != std::string_view::npos) { option.value = arg.substr(eq + 1); }
+			if (index < max_options_v) { options[index++] = option; }
 		} else {
-			for (char const& ch : arg) { options[index++] = {std::string_view{&ch, 1}}; }
+			for (char const& ch : arg) {
+				if (index < max_options_v) { options[index++] = {std::string_view{&ch, 1}}; }
+			}
 		}
 		return index;
 	}
@@ -0,0 +1,307 @@
+#include <server.hpp>
+#include <toylang/interpreter_pool.hpp>
+#include <toylang/util.hpp>
+#include <toylang/util/thread_pool.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TL_SERVER
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace toylang {
+#if defined(TL_SERVER)
+namespace {
+constexpr std::uint32_t max_payload_v{64 * 1024 * 1024};
+
+struct Frame {
+	char kind{};
+	std::string payload{};
+};
+
+using Clock = Interpreter::Clock;
+
+///
+/// \brief Without a per-request timeout a stalled client still only holds a worker this long while its request is read
+///
+constexpr auto read_timeout_v = std::chrono::milliseconds{5000};
+
+// false on end of stream, error, or once deadline passes with the data incomplete
+bool read_all(int fd, void* data, std::size_t size, Clock::time_point const deadline) {
+	auto* out = static_cast<char*>(data);
+	while (size > 0) {
+		auto const remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+		if (remaining <= 0) { return false; }
+		auto readable = pollfd{.fd = fd, .events = POLLIN, .revents = 0};
+		auto const polled = ::poll(&readable, 1, static_cast<int>(std::min<decltype(remaining)>(remaining, std::numeric_limits<int>::max())));
+		if (polled < 0 && errno == EINTR) { continue; }
+		if (polled <= 0) { return false; }
+		auto const ret = ::read(fd, out, size);
+		if (ret <= 0) { return false; }
+		out += ret;
+		size -= static_cast<std::size_t>(ret);
+	}
+	return true;
+}
+
+bool write_all(int fd, void const* data, std::size_t size) {
+	auto const* in = static_cast<char const*>(data);
+	while (size > 0) {
+		auto const ret = ::write(fd, in, size);
+		if (ret <= 0) { return false; }
+		in += ret;
+		size -= static_cast<std::size_t>(ret);
+	}
+	return true;
+}
+
+std::uint32_t to_le(std::uint32_t const value) {
+	auto ret = std::uint32_t{};
+	auto bytes = reinterpret_cast<unsigned char*>(&ret);
+	for (std::size_t i = 0; i < 4; ++i) { bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xff); }
+	return ret;
+}
+
+bool read_frame(int fd, Frame& out, Clock::time_point const deadline) {
+	char header[5];
+	if (!read_all(fd, header, sizeof(header), deadline)) { return false; }
+	auto size = std::uint32_t{};
+	std::memcpy(&size, header + 1, 4);
+	size = to_le(size);
+	if (size > max_payload_v) { return false; }
+	out.kind = header[0];
+	out.payload.resize(size);
+	return read_all(fd, out.payload.data(), size, deadline);
+}
+
+bool write_frame(int fd, char kind, std::string_view const payload) {
+	char header[5]{kind};
+	auto const size = to_le(static_cast<std::uint32_t>(payload.size()));
+	std::memcpy(header + 1, &size, 4);
+	return write_all(fd, header, sizeof(header)) && write_all(fd, payload.data(), payload.size());
+}
+
+///
+/// \brief Latencies of the most recent requests (bounded), for percentiles
+///
+struct Metrics {
+	static constexpr std::size_t capacity_v{64 * 1024};
+
+	std::mutex mutex{};
+	std::vector<double> latencies{};
+	std::size_t next{};
+	std::size_t requests{};
+	std::size_t errors{};
+	std::size_t timeouts{};
+
+	void record(double const micros, std::string_view const result) {
+		auto lock = std::scoped_lock{mutex};
+		++requests;
+		if (result == "error") { ++errors; }
+		if (result == "timeout") { ++timeouts; }
+		if (latencies.size() < capacity_v) {
+			latencies.push_back(micros);
+		} else {
+			latencies[next++ % capacity_v] = micros;
+		}
+	}
+
+	std::string report() {
+		auto sorted = std::vector<double>{};
+		auto ret = std::string{};
+		auto lock = std::unique_lock{mutex};
+		sorted = latencies;
+		util::append(ret, "requests: ", std::to_string(requests), "\nerrors: ", std::to_string(errors), "\ntimeouts: ", std::to_string(timeouts), "\n");
+		lock.unlock();
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](double p) {
+			if (sorted.empty()) { return 0.0; }
+			return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * static_cast<double>(sorted.size())))];
+		};
+		util::append(ret, "p50_us: ", std::to_string(percentile(0.5)), "\np99_us: ", std::to_string(percentile(0.99)), "\n");
+		return ret;
+	}
+};
+
+pollfd watch(int const fd) { return {.fd = fd, .events = POLLIN, .revents = 0}; }
+
+///
+/// \brief Output is sent in frames of about this size as the script produces it, rather than all at the end
+///
+constexpr std::size_t stream_chunk_v{16 * 1024};
+
+///
+/// \brief Handles one request on fd (false: the connection is done)
+///
+bool serve_one(int fd, InterpreterPool& pool, Metrics& metrics, std::chrono::milliseconds timeout) {
+	auto frame = Frame{};
+	// the connection was readable, but the rest of the frame may never come: reading has a deadline too (the connection is dropped)
+	if (!read_frame(fd, frame, Clock::now() + (timeout.count() > 0 ? timeout : read_timeout_v))) { return false; }
+	if (frame.kind == 's') { return write_frame(fd, 's', metrics.report()) && write_frame(fd, 'r', "ok"); }
+	if (frame.kind != 'x' && frame.kind != 'e') { return write_frame(fd, 'd', "Unknown request kind\n") && write_frame(fd, 'r', "error"); }
+	auto const start = Interpreter::Clock::now();
+	auto output = std::string{};
+	auto diagnostics = std::string{};
+	// once a write fails the client is gone: the request runs to completion (or its deadline) unobserved
+	auto connected = true;
+	auto lease = pool.acquire();
+	lease->redirect(&output, &diagnostics);
+	lease->on_output = [fd, &connected](std::string& out) {
+		if (out.size() < stream_chunk_v) { return; }
+		connected = connected && write_frame(fd, 'o', out);
+		out.clear();
+	};
+	if (timeout.count() > 0) { lease->deadline = start + timeout; }
+	bool const success = frame.payload.empty() || (frame.kind == 'e' ? lease->evaluate(frame.payload) : lease->execute({.text = frame.payload}));
+	auto const deadline = lease->deadline;
+	lease.release();
+	auto const end = Interpreter::Clock::now();
+	std::string_view const result = success ? "ok" : (end >= deadline ? "timeout" : "error");
+	metrics.record(std::chrono::duration<double, std::micro>(end - start).count(), result);
+	if (!connected) { return false; }
+	if (!output.empty() && !write_frame(fd, 'o', output)) { return false; }
+	if (!diagnostics.empty() && !write_frame(fd, 'd', diagnostics)) { return false; }
+	return write_frame(fd, 'r', result);
+}
+
+///
+/// \brief Connections handed back by workers after a request, to be polled again by the accepting thread
+///
+class Returned {
+  public:
+	Returned() {
+		if (::pipe(m_wake) != 0) { m_wake[0] = m_wake[1] = -1; }
+	}
+
+	Returned(Returned const&) = delete;
+	Returned& operator=(Returned const&) = delete;
+
+	~Returned() {
+		for (int const fd : m_fds) { ::close(fd); }
+		for (int const fd : m_wake) {
+			if (fd >= 0) { ::close(fd); }
+		}
+	}
+
+	explicit operator bool() const { return m_wake[0] >= 0; }
+
+	///
+	/// \brief Readable when connections have been handed back
+	///
+	int wake_fd() const { return m_wake[0]; }
+
+	void push(int const fd) {
+		auto lock = std::scoped_lock{m_mutex};
+		m_fds.push_back(fd);
+		char const byte{};
+		[[maybe_unused]] auto const written = ::write(m_wake[1], &byte, 1);
+	}
+
+	void drain_into(std::vector<pollfd>& out) {
+		char bytes[64];
+		[[maybe_unused]] auto const read = ::read(m_wake[0], bytes, sizeof(bytes));
+		auto lock = std::scoped_lock{m_mutex};
+		for (int const fd : m_fds) { out.push_back(watch(fd)); }
+		m_fds.clear();
+	}
+
+  private:
+	std::mutex m_mutex{};
+	std::vector<int> m_fds{};
+	int m_wake[2]{-1, -1};
+};
+} // namespace
+
+bool Server::run(Interpreter::Image image) const {
+	std::signal(SIGPIPE, SIG_IGN);
+	auto address = sockaddr_un{};
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+		std::fprintf(stderr, "Invalid socket path: %s\n", path.c_str());
+		return false;
+	}
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	int const listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		std::perror("socket");
+		return false;
+	}
+	::unlink(path.c_str());
+	if (::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0) {
+		std::perror("bind");
+		::close(listener);
+		return false;
+	}
+	auto interpreters = InterpreterPool{std::move(image)};
+	auto metrics = Metrics{};
+	// idle (keep-alive) connections wait here in poll(), not on a worker: each readable one is dispatched for a single request
+	auto returned = Returned{};
+	if (!returned) {
+		std::perror("pipe");
+		::close(listener);
+		return false;
+	}
+	auto workers = util::ThreadPool{jobs};
+	std::printf("Serving on %s (%zu job(s))\n", path.c_str(), workers.size());
+	std::fflush(stdout);
+	auto const dispatch = [&](int const fd) {
+		workers.push([fd, &interpreters, &metrics, &returned, timeout = timeout] {
+			if (serve_one(fd, interpreters, metrics, timeout)) {
+				returned.push(fd);
+			} else {
+				::close(fd);
+			}
+		});
+	};
+	// [0]: listener, [1]: returned connections, then idle connections
+	auto polled = std::vector<pollfd>{watch(listener), watch(returned.wake_fd())};
+	while (true) {
+		if (::poll(polled.data(), polled.size(), -1) < 0) {
+			if (errno == EINTR) { continue; }
+			std::perror("poll");
+			break;
+		}
+		for (std::size_t i = 2; i < polled.size();) {
+			if (polled[i].revents == 0) {
+				++i;
+				continue;
+			}
+			dispatch(polled[i].fd);
+			polled[i] = polled.back();
+			polled.pop_back();
+		}
+		if (polled[1].revents != 0) { returned.drain_into(polled); }
+		if (polled[0].revents != 0) {
+			int const fd = ::accept(listener, nullptr, nullptr);
+			if (fd >= 0) {
+				polled.push_back(watch(fd));
+			} else if (errno != EINTR && errno != ECONNABORTED) {
+				std::perror("accept");
+				break;
+			}
+		}
+	}
+	workers.wait();
+	for (std::size_t i = 2; i < polled.size(); ++i) { ::close(polled[i].fd); }
+	::close(listener);
+	::unlink(path.c_str());
+	return false;
+}
+#else
+bool Server::run(Interpreter::Image) const {
+	std::fprintf(stderr, "Server mode requires Unix domain sockets\n");
+	return false;
+}
+#endif
+} // namespace toylang
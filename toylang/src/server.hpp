@@ -0,0 +1,24 @@
+#pragma once
+#include <toylang/interpreter.hpp>
+#include <chrono>
+#include <string>
+
+namespace toylang {
+///
+/// \brief Persistent server over a Unix domain socket, executing requests on warm Interpreters cloned from an Image.
+///
+/// Every frame (both directions) is [kind: u8][size: u32 little endian][payload: size bytes].
+/// Requests: 'x' execute script, 'e' evaluate expression, 's' stats.
+/// Responses: zero or more 'o' (output) / 'd' (diagnostics) / 's' (stats) frames,
+/// then one 'r' frame whose payload is "ok", "error" or "timeout". Output is streamed in 'o' frames while the request runs.
+/// Connections may send any number of requests; each is a task on the workers, an idle connection holds none.
+/// A request's frame must arrive within timeout (5 seconds without one), or the connection is closed.
+///
+struct Server {
+	std::string path{};
+	std::size_t jobs{};
+	std::chrono::milliseconds timeout{};
+
+	bool run(Interpreter::Image image) const;
+};
+} // namespace toylang
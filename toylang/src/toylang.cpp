@@ -1,6 +1,13 @@
 #include <cmd_args.hpp>
+#include <server.hpp>
 #include <toylang/interpreter.hpp>
+#include <toylang/stdlib.hpp>
 #include <toylang/util.hpp>
+#include <toylang/util/thread_pool.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
 
@@ -13,14 +20,8 @@ struct Runner {
 
 	bool execute(Source script) { return interpreter.execute_or_evaluate(script); }
 
-	bool open(char const* path) {
-		auto text = util::read_file(path);
-		if (text.empty()) {
-			std::cerr << "Failed to open " << path << '\n';
-			return false;
-		}
-		return execute({.filename = path, .text = text});
-	}
+	// not only regular files: a script may be piped in (/dev/stdin)
+	bool open(char const* path) { return interpreter.execute_or_evaluate_file(path); }
 
 	void run(std::string_view cursor = ">") {
 		auto write_cursor = [c = cursor] { std::cout << c << " "; };
@@ -34,22 +35,98 @@ struct Runner {
 	}
 };
 
+///
+/// \brief Runs each script in its own Interpreter (cloned from image) on a thread pool; output is collected per script
+///
+struct Batch {
+	struct Result {
+		std::string path{};
+		std::string output{};
+		std::string diagnostics{};
+		double seconds{};
+		bool success{};
+	};
+
+	static std::vector<std::string> collect(std::span<char const* const> args) {
+		auto ret = std::vector<std::string>{};
+		for (char const* arg : args) {
+			if (fs::is_directory(arg)) {
+				auto scripts = std::vector<std::string>{};
+				for (auto const& entry : fs::recursive_directory_iterator{arg}) {
+					if (entry.is_regular_file() && entry.path().extension() == ".tl") { scripts.push_back(entry.path().generic_string()); }
+				}
+				std::sort(scripts.begin(), scripts.end());
+				std::move(scripts.begin(), scripts.end(), std::back_inserter(ret));
+			} else {
+				ret.emplace_back(arg);
+			}
+		}
+		return ret;
+	}
+
+	static Result execute(Interpreter::Image const& image, std::string path) {
+		using clock = std::chrono::steady_clock;
+		auto ret = Result{.path = std::move(path)};
+		auto const start = clock::now();
+		auto interpreter = Interpreter{image};
+		interpreter.redirect(&ret.output, &ret.diagnostics);
+		ret.success = interpreter.execute_or_evaluate_file(ret.path.c_str());
+		ret.seconds = std::chrono::duration<double>(clock::now() - start).count();
+		return ret;
+	}
+
+	static bool run(Interpreter::Image const& image, std::span<char const* const> args, std::size_t jobs) {
+		using clock = std::chrono::steady_clock;
+		auto const start = clock::now();
+		auto const paths = collect(args);
+		auto results = std::vector<Result>(paths.size());
+		{
+			auto pool = util::ThreadPool{jobs};
+			for (std::size_t i = 0; i < paths.size(); ++i) {
+				pool.push([&image, &results, &paths, i] { results[i] = execute(image, paths[i]); });
+			}
+		}
+		auto const wall = std::chrono::duration<double>(clock::now() - start).count();
+		auto failed = std::size_t{};
+		auto total = double{};
+		for (auto const& result : results) {
+			std::printf("==> %s <==\n", result.path.c_str());
+			std::fwrite(result.output.data(), 1, result.output.size(), stdout);
+			std::fflush(stdout);
+			std::fwrite(result.diagnostics.data(), 1, result.diagnostics.size(), stderr);
+			if (!result.success) { ++failed; }
+			total += result.seconds;
+		}
+		std::printf("\n%zu script(s), %zu failed, %zu job(s)\n", results.size(), failed, jobs);
+		for (auto const& result : results) { std::printf("  %s %9.4fs  %s\n", result.success ? "[ok]  " : "[fail]", result.seconds, result.path.c_str()); }
+		std::printf("wall: %.4fs  total: %.4fs\n", wall, total);
+		return failed == 0;
+	}
+};
+
+std::size_t parse_number(std::string_view const value) {
+	auto ret = std::size_t{};
+	std::from_chars(value.data(), value.data() + value.size(), ret);
+	return ret;
+}
+
+std::size_t parse_jobs(std::string_view const value) {
+	auto ret = parse_number(value);
+	if (ret == 0) { ret = std::max(std::thread::hardware_concurrency(), 1U); }
+	return ret;
+}
+
 int run(int argc, char const* const argv[]) {
 	auto const exe_path = fs::absolute(argv[0]);
 	auto const exe_name = exe_path.filename().generic_string();
-	auto const stdlib_path = [&] {
-		for (fs::path path = exe_path; !path.empty() && path.parent_path() != path; path = path.parent_path()) {
-			auto ret = path / "stdlib";
-			if (fs::is_regular_file(ret / "std.tl")) { return ret.generic_string(); }
-			ret = path / "toylang/stdlib";
-			if (fs::is_regular_file(ret / "std.tl")) { return ret.generic_string(); }
-		}
-		return std::string{};
-	}();
 	auto args = CmdArgs{argc, argv};
 	if (args.option("help")) {
-		std::cout << "Usage: " << exe_name << " [path/to/script] [--options]\n\n";
+		std::cout << "Usage: " << exe_name << " [--options] [path/to/script...]\n\n";
 		std::cout << "OPTIONS\n\n[ --verbose | -v ] \tPrint lots of debug text\n";
+		std::cout << "[ --module-cache | -c ] \tCache compiled imports as .tlc files next to their sources\n";
+		std::cout << "[ --jobs N | -j N ] \tRun every script (or *.tl in directories) on N threads (0: all cores) and summarize\n";
+		std::cout << "[ --serve <socket> ] \tServe script / expression requests over a Unix domain socket (with --jobs workers)\n";
+		std::cout << "[ --timeout <ms> ] \tPer-request time limit in server mode (default: 5000, 0: none)\n";
 		return EXIT_SUCCESS;
 	}
 	auto debug_flags = toylang::Interpreter::Debug{};
@@ -59,10 +136,19 @@ int run(int argc, char const* const argv[]) {
 	}
 	auto runner = toylang::Runner{};
 	runner.interpreter.debug = debug_flags;
+	runner.interpreter.cache.modules = static_cast<bool>(args.option("module-cache", 'c'));
 	runner.interpreter.media.mount(exe_path.parent_path().generic_string());
-	if (!stdlib_path.empty()) {
-		runner.interpreter.media.mount(stdlib_path);
-		runner.interpreter.execute({.text = R"(import "std.tl";)"});
+	runner.interpreter.media.embedded = stdlib::files();
+	runner.interpreter.execute({.text = R"(import "std.tl";)"});
+	if (auto const serve = args.option("serve")) {
+		auto server = Server{.path = std::string{serve.value}, .jobs = parse_jobs(args.option("jobs", 'j').value)};
+		auto const timeout = args.option("timeout");
+		server.timeout = std::chrono::milliseconds{timeout ? parse_number(timeout.value) : 5000};
+		return server.run(runner.interpreter.snapshot()) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (auto const jobs = args.option("jobs", 'j')) {
+		auto const image = runner.interpreter.snapshot();
+		return Batch::run(image, args.args, parse_jobs(jobs.value)) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
 	if (args.args.empty()) {
 		runner.run();